@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Lock-free bounded queue for many producers and a single consumer. Every cell carries
+// a sequence number telling whose turn it is: a producer claims a cell by moving the tail,
+// and publishes the value by advancing the cell's sequence
+template <typename Value>
+class BoundedMpscQueue {
+public:
+    static_assert(std::is_trivially_copyable_v<Value>, "BoundedMpscQueue supports only trivially copyable values");
+    
+public:
+    // Capacity is rounded up to a power of two so that a position maps to its cell with a mask,
+    // e.g. a queue constructed with capacity 3 holds 4 values. GetCapacity returns the rounded value
+    explicit BoundedMpscQueue(size_t capacity)
+    : capacity_(RoundUpToPowerOfTwo(capacity))
+    , cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+public:
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+    
+    // Returns false if the queue is full, safe to call from any thread
+    bool TryPush(const Value& value) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        
+        while (true) {
+            Cell& cell = cells_[position & (capacity_ - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            
+            if (difference == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    
+                    return true;
+                }
+            } else if (difference < 0) {
+                // the consumer has not freed the cell from the previous lap yet
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    // Returns false if the queue is empty, only one thread at a time may call it
+    bool TryPop(Value& value) {
+        Cell& cell = cells_[head_ & (capacity_ - 1)];
+        
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        
+        value = cell.value;
+        cell.sequence.store(head_ + capacity_, std::memory_order_release);
+        ++head_;
+        
+        return true;
+    }
+    
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        Value value{};
+    };
+    
+private:
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        
+        while (result < value) {
+            result *= 2;
+        }
+        
+        return result;
+    }
+    
+private:
+    const size_t capacity_;
+    std::unique_ptr<Cell[]> cells_;
+    
+    // producers and the consumer touch different cache lines
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+};
@@ -0,0 +1,248 @@
+#include "compressed_postings.hpp"
+
+// The shuffle decoder is compiled for SSSE3 whatever the build flags and chosen at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEARCH_SERVER_SSSE3_DECODER
+#include <immintrin.h>
+#endif
+
+// Ids are encoded in groups of four: a control byte holds the byte count - 1 of every
+// delta in two bits, the deltas follow as little-endian bytes. The last group of a block
+// is padded with zero deltas, so decoding always writes whole groups
+namespace {
+
+constexpr size_t kGroupSize = 4;
+constexpr size_t kPaddingSize = 16;
+
+size_t GetGroupCount(size_t count) {
+    return (count + kGroupSize - 1) / kGroupSize;
+}
+
+uint32_t GetByteCount(uint32_t value) {
+    return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+void DecodeGroupsScalar(const uint8_t* control, const uint8_t* data, size_t group_count, uint32_t base,
+                        int* document_ids) {
+    uint32_t document_id = base;
+    
+    for (size_t i = 0; i < group_count * kGroupSize; ++i) {
+        const uint32_t byte_count = ((control[i / kGroupSize] >> (2 * (i % kGroupSize))) & 3) + 1;
+        
+        uint32_t delta = 0;
+        
+        for (uint32_t byte = 0; byte < byte_count; ++byte) {
+            delta |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+        }
+        
+        data += byte_count;
+        
+        document_id += delta;
+        document_ids[i] = static_cast<int>(document_id);
+    }
+} // DecodeGroupsScalar
+
+#if defined(SEARCH_SERVER_SSSE3_DECODER)
+
+// Shuffle masks moving the deltas of a group to 32-bit lanes, and the byte counts of groups
+struct GroupTables {
+    alignas(16) uint8_t shuffle_masks[256][16];
+    uint8_t lengths[256];
+};
+
+const GroupTables& GetGroupTables() {
+    static const GroupTables tables = [] {
+        GroupTables result {};
+        
+        for (uint32_t control = 0; control < 256; ++control) {
+            uint8_t offset = 0;
+            
+            for (uint32_t lane = 0; lane < kGroupSize; ++lane) {
+                const uint32_t byte_count = ((control >> (2 * lane)) & 3) + 1;
+                
+                for (uint32_t byte = 0; byte < 4; ++byte) {
+                    // the high bit makes the shuffle write zero
+                    result.shuffle_masks[control][4 * lane + byte] = byte < byte_count ? offset + byte : 0x80;
+                }
+                
+                offset += byte_count;
+            }
+            
+            result.lengths[control] = offset;
+        }
+        
+        return result;
+    }();
+    
+    return tables;
+}
+
+__attribute__((target("ssse3")))
+void DecodeGroupsSsse3(const uint8_t* control, const uint8_t* data, size_t group_count, uint32_t base,
+                       int* document_ids) {
+    const GroupTables& tables = GetGroupTables();
+    
+    __m128i previous = _mm_set1_epi32(static_cast<int>(base));
+    
+    for (size_t group = 0; group < group_count; ++group) {
+        const uint8_t group_control = control[group];
+        
+        const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.shuffle_masks[group_control]));
+        __m128i values = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), mask);
+        data += tables.lengths[group_control];
+        
+        // prefix sum of the four deltas on top of the last id of the previous group
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, previous);
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(document_ids + group * kGroupSize), values);
+        
+        previous = _mm_shuffle_epi32(values, 0xFF);
+    }
+} // DecodeGroupsSsse3
+
+bool HasSsse3() {
+#if defined(__SSSE3__)
+    return true;
+#else
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    
+    return has_ssse3;
+#endif
+}
+
+#endif
+
+} // namespace
+
+CompressedPostings::CompressedPostings(const std::vector<Posting>& postings) {
+    blocks_.reserve((postings.size() + kBlockSize - 1) / kBlockSize);
+    term_frequencies_.reserve(postings.size());
+    statuses_.reserve(postings.size());
+    
+    uint32_t previous_document_id = 0;
+    
+    for (size_t first = 0; first < postings.size(); first += kBlockSize) {
+        const size_t count = std::min(kBlockSize, postings.size() - first);
+        const size_t group_count = GetGroupCount(count);
+        
+        Block block;
+        block.encoded_offset = static_cast<uint32_t>(encoded_document_ids_.size());
+        
+        const size_t control_offset = encoded_document_ids_.size();
+        encoded_document_ids_.resize(control_offset + group_count, 0);
+        
+        for (size_t i = 0; i < group_count * kGroupSize; ++i) {
+            uint32_t delta = 0;
+            
+            if (i < count) {
+                const Posting& posting = postings[first + i];
+                
+                delta = static_cast<uint32_t>(posting.document_id) - previous_document_id;
+                previous_document_id = static_cast<uint32_t>(posting.document_id);
+                
+                term_frequencies_.push_back(static_cast<float>(posting.term_frequency));
+                statuses_.push_back(static_cast<uint8_t>(posting.status));
+                
+                block.max_term_frequency = std::max(block.max_term_frequency, term_frequencies_.back());
+            }
+            
+            const uint32_t byte_count = GetByteCount(delta);
+            
+            encoded_document_ids_[control_offset + i / kGroupSize] |= static_cast<uint8_t>((byte_count - 1) << (2 * (i % kGroupSize)));
+            
+            for (uint32_t byte = 0; byte < byte_count; ++byte) {
+                encoded_document_ids_.push_back(static_cast<uint8_t>(delta >> (8 * byte)));
+            }
+        }
+        
+        block.last_document_id = static_cast<int>(previous_document_id);
+        blocks_.push_back(block);
+    }
+    
+    encoded_document_ids_.resize(encoded_document_ids_.size() + kPaddingSize, 0);
+    encoded_document_ids_.shrink_to_fit();
+} // CompressedPostings
+
+size_t CompressedPostings::size() const {
+    return term_frequencies_.size();
+}
+
+bool CompressedPostings::empty() const {
+    return term_frequencies_.empty();
+}
+
+bool CompressedPostings::Find(int document_id, Posting& posting) const {
+    const auto block = std::lower_bound(blocks_.begin(), blocks_.end(), document_id, [](const Block& block, int document_id) {
+        return block.last_document_id < document_id;
+    });
+    
+    if (block == blocks_.end()) {
+        return false;
+    }
+    
+    const size_t block_index = static_cast<size_t>(block - blocks_.begin());
+    const size_t first = block_index * kBlockSize;
+    const size_t count = std::min(kBlockSize, size() - first);
+    
+    int document_ids[kBlockSize];
+    DecodeDocumentIds(block_index, document_ids);
+    
+    const int* position = std::lower_bound(document_ids, document_ids + count, document_id);
+    
+    if (position == document_ids + count || *position != document_id) {
+        return false;
+    }
+    
+    const size_t index = first + static_cast<size_t>(position - document_ids);
+    posting = {document_id, static_cast<DocumentStatus>(statuses_[index]), term_frequencies_[index]};
+    
+    return true;
+} // Find
+
+size_t CompressedPostings::GetByteSize() const {
+    return blocks_.size() * sizeof(Block) + encoded_document_ids_.size()
+        + term_frequencies_.size() * sizeof(float) + statuses_.size();
+}
+
+size_t CompressedPostings::GetBlockCount() const {
+    return blocks_.size();
+}
+
+const CompressedPostings::Block& CompressedPostings::GetBlock(size_t block_index) const {
+    return blocks_[block_index];
+}
+
+size_t CompressedPostings::DecodeBlock(size_t block_index, Posting* postings) const {
+    const size_t first = block_index * kBlockSize;
+    const size_t count = std::min(kBlockSize, size() - first);
+    
+    int document_ids[kBlockSize];
+    DecodeDocumentIds(block_index, document_ids);
+    
+    for (size_t i = 0; i < count; ++i) {
+        postings[i] = {document_ids[i], static_cast<DocumentStatus>(statuses_[first + i]), term_frequencies_[first + i]};
+    }
+    
+    return count;
+} // DecodeBlock
+
+void CompressedPostings::DecodeDocumentIds(size_t block_index, int* document_ids) const {
+    const size_t count = std::min(kBlockSize, size() - block_index * kBlockSize);
+    const size_t group_count = GetGroupCount(count);
+    
+    const uint8_t* control = encoded_document_ids_.data() + blocks_[block_index].encoded_offset;
+    const uint8_t* data = control + group_count;
+    
+    const uint32_t base = block_index == 0 ? 0 : static_cast<uint32_t>(blocks_[block_index - 1].last_document_id);
+    
+#if defined(SEARCH_SERVER_SSSE3_DECODER)
+    if (HasSsse3()) {
+        DecodeGroupsSsse3(control, data, group_count, base, document_ids);
+        return;
+    }
+#endif
+    
+    DecodeGroupsScalar(control, data, group_count, base, document_ids);
+} // DecodeDocumentIds
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "posting.hpp"
+
+// Read-only postings packed in blocks of kBlockSize. Document ids are delta-encoded
+// with StreamVByte, term frequencies are narrowed to float and statuses to a byte,
+// which takes about 6 bytes per posting instead of 16. A float keeps 24 bits of the term
+// frequency, so a relevance moves by at most its value times 2^-24: rounding never reverses
+// the order of two frequencies, but sums of several words may swap documents whose
+// relevances differ by less than that, and such near ties are ordered by rating anyway
+// once they are closer than SearchServer's accuracy
+class CompressedPostings {
+public:
+    static constexpr size_t kBlockSize = 128;
+    
+    struct Block {
+        int last_document_id = 0;
+        uint32_t encoded_offset = 0;
+        float max_term_frequency = 0.0f;
+    };
+    
+public:
+    CompressedPostings() = default;
+    
+    // postings must be sorted by document id
+    explicit CompressedPostings(const std::vector<Posting>& postings);
+    
+public:
+    size_t size() const;
+    
+    bool empty() const;
+    
+    bool Find(int document_id, Posting& posting) const;
+    
+    // Bytes taken by the packed postings
+    size_t GetByteSize() const;
+    
+    size_t GetBlockCount() const;
+    
+    const Block& GetBlock(size_t block_index) const;
+    
+    // Writes the postings of the block, which must have room for kBlockSize of them, returns their count
+    size_t DecodeBlock(size_t block_index, Posting* postings) const;
+    
+    template<typename Function>
+    void ForEach(Function function) const;
+    
+    // Calls function for the postings of blocks from first_block up to last_block, not including it
+    template<typename Function>
+    void ForEachInBlocks(size_t first_block, size_t last_block, Function function) const;
+    
+private:
+    // Writes the ids of the block to document_ids, which must have room for kBlockSize values
+    void DecodeDocumentIds(size_t block_index, int* document_ids) const;
+    
+private:
+    std::vector<Block> blocks_;
+    
+    // control bytes followed by data bytes for every block, padded for vector loads
+    std::vector<uint8_t> encoded_document_ids_;
+    
+    std::vector<float> term_frequencies_;
+    
+    std::vector<uint8_t> statuses_;
+};
+
+template<typename Function>
+void CompressedPostings::ForEach(Function function) const {
+    ForEachInBlocks(0, blocks_.size(), function);
+}
+
+template<typename Function>
+void CompressedPostings::ForEachInBlocks(size_t first_block, size_t last_block, Function function) const {
+    int document_ids[kBlockSize];
+    
+    for (size_t block_index = first_block; block_index < std::min(last_block, blocks_.size()); ++block_index) {
+        DecodeDocumentIds(block_index, document_ids);
+        
+        const size_t first = block_index * kBlockSize;
+        const size_t count = std::min(kBlockSize, size() - first);
+        
+        for (size_t i = 0; i < count; ++i) {
+            function(Posting{document_ids[i], static_cast<DocumentStatus>(statuses_[first + i]),
+                             term_frequencies_[first + i]});
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+
+// Map split into independently locked buckets, so that threads touching
+// different keys rarely wait for each other
+template <typename Key, typename Value>
+class ConcurrentMap {
+private:
+    struct Bucket {
+        std::mutex mutex;
+        std::map<Key, Value> map;
+    };
+
+public:
+    static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
+
+    struct Access {
+        Access(const Key& key, Bucket& bucket): guard(bucket.mutex), ref_to_value(bucket.map[key]) {}
+
+        std::lock_guard<std::mutex> guard;
+        Value& ref_to_value;
+    };
+
+public:
+    explicit ConcurrentMap(size_t bucket_count): buckets_(bucket_count) {}
+
+public:
+    Access operator[](const Key& key) {
+        return Access(key, GetBucket(key));
+    }
+
+    void Erase(const Key& key) {
+        Bucket& bucket = GetBucket(key);
+
+        std::lock_guard guard(bucket.mutex);
+        bucket.map.erase(key);
+    }
+
+    std::map<Key, Value> BuildOrdinaryMap() {
+        std::map<Key, Value> result;
+
+        for (Bucket& bucket : buckets_) {
+            std::lock_guard guard(bucket.mutex);
+            result.insert(bucket.map.begin(), bucket.map.end());
+        }
+
+        return result;
+    }
+
+private:
+    Bucket& GetBucket(const Key& key) {
+        return buckets_[static_cast<uint64_t>(key) % buckets_.size()];
+    }
+
+private:
+    std::vector<Bucket> buckets_;
+};
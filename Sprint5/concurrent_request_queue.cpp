@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include "concurrent_request_queue.hpp"
+
+ConcurrentRequestQueue::ConcurrentRequestQueue(const SearchServer& search_server, Clock::duration window_duration,
+                                               size_t window_capacity, ClockFunction clock)
+: server_(search_server)
+, clock_(std::move(clock))
+, buffer_(kBufferCapacity)
+, window_(window_duration, window_capacity) {}
+
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(std::string_view raw_query, DocumentStatus status) {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, status);
+    
+    RecordRequest(static_cast<int>(results.size()));
+    
+    return results;
+}
+
+int ConcurrentRequestQueue::GetNoResultRequests() const {
+    return no_result_requests_.load(std::memory_order_acquire);
+}
+
+void ConcurrentRequestQueue::Aggregate() {
+    std::lock_guard guard(aggregation_mutex_);
+    
+    MergeBuffer();
+}
+
+void ConcurrentRequestQueue::RecordRequest(int result_count) {
+    const RequestRecord record{clock_(), result_count};
+    
+    // a full buffer means the aggregator is behind, so the producer helps it
+    while (!buffer_.TryPush(record)) {
+        Aggregate();
+    }
+    
+    std::unique_lock lock(aggregation_mutex_, std::try_to_lock);
+    
+    if (lock.owns_lock()) {
+        MergeBuffer();
+    }
+} // RecordRequest
+
+void ConcurrentRequestQueue::MergeBuffer() {
+    RequestRecord record;
+    
+    while (buffer_.TryPop(record)) {
+        // records of different threads may come slightly out of order, the window needs them ordered
+        last_timestamp_ = std::max(last_timestamp_, record.timestamp);
+        
+        window_.Record(last_timestamp_, record.result_count);
+    }
+    
+    no_result_requests_.store(window_.GetNoResultCount(std::max(last_timestamp_, clock_())), std::memory_order_release);
+} // MergeBuffer
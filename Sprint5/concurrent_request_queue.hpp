@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "document.hpp"
+#include "search_server.hpp"
+#include "request_window.hpp"
+#include "bounded_mpsc_queue.hpp"
+
+// RequestQueue to be shared by query threads. Requests are pushed to a lock-free buffer,
+// and whichever thread finds the aggregator free merges the buffer into the window;
+// the others go on without waiting
+class ConcurrentRequestQueue {
+public:
+    using Clock = RequestWindow::Clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+    
+public:
+    explicit ConcurrentRequestQueue(const SearchServer& search_server,
+                                    Clock::duration window_duration = std::chrono::hours(24),
+                                    size_t window_capacity = kDefaultWindowCapacity,
+                                    ClockFunction clock = Clock::now);
+    
+public:
+    template <typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
+    
+    std::vector<Document> AddFindRequest(std::string_view raw_query,
+                                         DocumentStatus status = DocumentStatus::kActual);
+    
+    // As of the last merge of the buffer into the window
+    int GetNoResultRequests() const;
+    
+    // Merges recorded requests into the window, waiting for a running merge if there is one
+    void Aggregate();
+    
+private:
+    struct RequestRecord {
+        Clock::time_point timestamp;
+        int result_count = 0;
+    };
+    
+private:
+    static constexpr size_t kDefaultWindowCapacity = 1 << 16;
+    static constexpr size_t kBufferCapacity = 1 << 12;
+    
+private:
+    void RecordRequest(int result_count);
+    
+    // Requires aggregation_mutex_
+    void MergeBuffer();
+    
+private:
+    const SearchServer& server_;
+    ClockFunction clock_;
+    
+    BoundedMpscQueue<RequestRecord> buffer_;
+    
+    std::mutex aggregation_mutex_;
+    RequestWindow window_;
+    Clock::time_point last_timestamp_;
+    
+    std::atomic<int> no_result_requests_{0};
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(std::string_view raw_query,
+                                                             DocumentPredicate document_predicate) {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, document_predicate);
+    
+    RecordRequest(static_cast<int>(results.size()));
+    
+    return results;
+}
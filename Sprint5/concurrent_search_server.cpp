@@ -0,0 +1,105 @@
+#include <mutex>
+#include <stdexcept>
+
+#include "concurrent_search_server.hpp"
+
+using namespace std::literals;
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words, size_t stripe_count,
+                                               size_t result_cache_capacity)
+: stripes_(stripe_count)
+, result_cache_(result_cache_capacity > 0 ? std::make_unique<QueryResultCache>(result_cache_capacity) : nullptr) {
+    if (stripe_count == 0) {
+        throw std::invalid_argument("at least one stripe is required"s);
+    }
+    
+    for (Stripe& stripe : stripes_) {
+        stripe.search_server = SearchServer(stop_words);
+    }
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                         const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("negative ids are not allowed"s);
+    }
+    
+    Stripe& stripe = GetStripe(document_id);
+    
+    std::unique_lock guard(stripe.mutex);
+    
+    stripe.search_server.AddDocument(document_id, document, status, ratings);
+    
+    document_count_.fetch_add(1, std::memory_order_relaxed);
+    index_epoch_.fetch_add(1, std::memory_order_release);
+} // AddDocument
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    if (document_id < 0) {
+        return;
+    }
+    
+    Stripe& stripe = GetStripe(document_id);
+    
+    std::unique_lock guard(stripe.mutex);
+    
+    const int stripe_document_count = stripe.search_server.GetDocumentCount();
+    
+    stripe.search_server.RemoveDocument(document_id);
+    
+    if (stripe.search_server.GetDocumentCount() != stripe_document_count) {
+        document_count_.fetch_sub(1, std::memory_order_relaxed);
+        index_epoch_.fetch_add(1, std::memory_order_release);
+    }
+} // RemoveDocument
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return document_count_.load(std::memory_order_relaxed);
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus desired_status,
+                                                               int max_result_document_count) const {
+    CheckResultDocumentCount(max_result_document_count);
+    
+    // stop words never change, so any stripe parses the query without a lock
+    ShardQuery query(stripes_.front().search_server, raw_query);
+    
+    // read before the stripes, so a result missing a change is never cached under the epoch of that change
+    const uint64_t index_epoch = index_epoch_.load(std::memory_order_acquire);
+    
+    std::string cache_key;
+    std::vector<Document> result;
+    
+    if (result_cache_) {
+        cache_key = query.GetResultCacheKey(desired_status, max_result_document_count);
+        
+        if (result_cache_->Find(cache_key, index_epoch, result)) {
+            return result;
+        }
+    }
+    
+    result = FindTopStripeDocuments(query, [desired_status, max_result_document_count](const ShardQuery& query,
+                                                                                        const SearchServer& search_server) {
+        return query.FindTopDocuments(search_server, desired_status, max_result_document_count);
+    }, max_result_document_count);
+    
+    if (result_cache_) {
+        result_cache_->Insert(cache_key, index_epoch, result);
+    }
+    
+    return result;
+} // FindTopDocuments
+
+QueryResultCache::Statistics ConcurrentSearchServer::GetResultCacheStatistics() const {
+    return result_cache_ ? result_cache_->GetStatistics() : QueryResultCache::Statistics{};
+}
+
+ConcurrentSearchServer::Stripe& ConcurrentSearchServer::GetStripe(int document_id) {
+    return stripes_[static_cast<size_t>(document_id) % stripes_.size()];
+}
+
+void ConcurrentSearchServer::CheckResultDocumentCount(int max_result_document_count) {
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <execution>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+#include "document.hpp"
+#include "result_cache.hpp"
+#include "search_server.hpp"
+#include "shard_query.hpp"
+
+// Index that takes documents while it is queried. Documents are split by id into stripes,
+// each a SearchServer with its own dictionary, document table and lock, so writers of different
+// stripes do not wait for each other and a document is found by queries as soon as it is added.
+// A query locks one stripe at a time in shared mode: it first sums the document counts of the stripes,
+// then searches them in parallel, so a writer waits for a single stripe search at most. A change made
+// between the two passes is ranked with the counts taken before it; once no writer runs, a query ranks
+// exactly as a single SearchServer holding the whole index would
+class ConcurrentSearchServer {
+public:
+    static constexpr size_t kDefaultStripeCount = 16;
+    
+public:
+    // zero capacity turns the result cache off
+    explicit ConcurrentSearchServer(std::string_view stop_words, size_t stripe_count = kDefaultStripeCount,
+                                    size_t result_cache_capacity = 0);
+    
+public:
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    
+    void RemoveDocument(int document_id);
+    
+    int GetDocumentCount() const;
+    
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           DocumentStatus desired_status = DocumentStatus::kActual,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    template<typename Predicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    QueryResultCache::Statistics GetResultCacheStatistics() const;
+    
+private:
+    struct Stripe {
+        mutable std::shared_mutex mutex;
+        SearchServer search_server;
+    };
+    
+private:
+    Stripe& GetStripe(int document_id);
+    
+    // find_stripe_documents(query, search_server) searches a single stripe while only that stripe is locked
+    template<typename FindStripeDocuments>
+    std::vector<Document> FindTopStripeDocuments(ShardQuery& query, FindStripeDocuments find_stripe_documents,
+                                                 int max_result_document_count) const;
+    
+    static void CheckResultDocumentCount(int max_result_document_count);
+    
+private:
+    std::vector<Stripe> stripes_;
+    
+    std::atomic<int> document_count_{0};
+    
+    // changed by every addition and removal, results cached before a change are not used after it
+    std::atomic<uint64_t> index_epoch_{0};
+    
+    std::unique_ptr<QueryResultCache> result_cache_;
+};
+
+template<typename Predicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                                               int max_result_document_count) const {
+    CheckResultDocumentCount(max_result_document_count);
+    
+    // stop words never change, so any stripe parses the query without a lock
+    ShardQuery query(stripes_.front().search_server, raw_query);
+    
+    return FindTopStripeDocuments(query, [&predicate, max_result_document_count](const ShardQuery& query,
+                                                                                  const SearchServer& search_server) {
+        return query.FindTopDocuments(search_server, predicate, max_result_document_count);
+    }, max_result_document_count);
+} // FindTopDocuments with predicate
+
+template<typename FindStripeDocuments>
+std::vector<Document> ConcurrentSearchServer::FindTopStripeDocuments(ShardQuery& query,
+                                                                     FindStripeDocuments find_stripe_documents,
+                                                                     int max_result_document_count) const {
+    for (const Stripe& stripe : stripes_) {
+        std::shared_lock guard(stripe.mutex);
+        query.AddShardStatistics(stripe.search_server);
+    }
+    
+    // counts that lag behind the postings still give finite and non-negative frequencies
+    std::vector<std::vector<Document>> stripe_results(stripes_.size());
+    
+    std::transform(std::execution::par, stripes_.begin(), stripes_.end(), stripe_results.begin(), [&](const Stripe& stripe) {
+        std::shared_lock guard(stripe.mutex);
+        
+        return find_stripe_documents(query, stripe.search_server);
+    });
+    
+    return ShardQuery::MergeTopDocuments(stripe_results, max_result_document_count);
+} // FindTopStripeDocuments
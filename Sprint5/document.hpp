@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 struct Document {
     int id = 0;
@@ -18,6 +20,14 @@ enum class DocumentStatus {
     kRemoved,
 };
 
+// Document as it comes for indexing, content must outlive the call that adds it
+struct RawDocument {
+    int id = 0;
+    std::string_view content;
+    DocumentStatus status = DocumentStatus::kActual;
+    std::vector<int> ratings;
+};
+
 std::ostream& operator<<(std::ostream& out, const DocumentStatus status);
 
 void PrintDocument(const Document& document);
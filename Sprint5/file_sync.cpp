@@ -0,0 +1,45 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file_sync.hpp"
+
+using namespace std::literals;
+
+namespace file_sync {
+
+namespace {
+
+void SyncPath(const std::string& path, int flags) {
+    const int file_descriptor = open(path.c_str(), flags);
+    
+    if (file_descriptor < 0) {
+        throw std::runtime_error("cannot open "s + path);
+    }
+    
+    const bool is_synced = fsync(file_descriptor) == 0;
+    close(file_descriptor);
+    
+    if (!is_synced) {
+        throw std::runtime_error("cannot sync "s + path);
+    }
+}
+
+}
+
+void SyncFile(const std::string& path) {
+    SyncPath(path, O_RDONLY);
+}
+
+void SyncParentDirectory(const std::string& path) {
+    const size_t separator = path.find_last_of('/');
+    
+    if (separator == std::string::npos) {
+        SyncPath("."s, O_RDONLY | O_DIRECTORY);
+    } else {
+        SyncPath(separator == 0 ? "/"s : path.substr(0, separator), O_RDONLY | O_DIRECTORY);
+    }
+} // SyncParentDirectory
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// A file replaced by rename survives a crash only once both its data and the directory entry are synced
+namespace file_sync {
+
+// Flushes the data of the file to the disk
+void SyncFile(const std::string& path);
+
+// Flushes the directory containing path, which makes a rename or creation of the file durable
+void SyncParentDirectory(const std::string& path);
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Word and integer hashes shared by the duplicate detectors
+namespace hashing {
+
+// Finalizer of SplitMix64, spreads every input bit over the whole result
+inline uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    
+    return value;
+}
+
+// FNV-1a
+inline uint64_t HashWord(std::string_view word) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    
+    for (const char c : word) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001B3ull;
+    }
+    
+    return hash;
+}
+
+} // namespace hashing
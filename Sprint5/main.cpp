@@ -42,7 +42,9 @@ int main() {
     search_server_helpers::AddDocument(search_server, 9, "nasty rat with curly hair"s, DocumentStatus::kActual, {1, 2});
     
     std::cout << "Before duplicates removed: "s << search_server.GetDocumentCount() << std::endl;
-    remove_duplicates::RemoveDuplicates(search_server);
+    for (const int document_id : remove_duplicates::RemoveDuplicates(search_server)) {
+        std::cout << "Found duplicate document id "s << document_id << std::endl;
+    }
     std::cout << "After duplsicates removed: "s << search_server.GetDocumentCount() << std::endl;
 }
 
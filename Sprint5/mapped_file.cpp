@@ -0,0 +1,50 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+using namespace std::literals;
+
+MappedFile::MappedFile(const std::string& path) {
+    const int file_descriptor = open(path.c_str(), O_RDONLY);
+    
+    if (file_descriptor < 0) {
+        throw std::runtime_error("cannot open "s + path);
+    }
+    
+    struct stat file_status {};
+    
+    if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0) {
+        close(file_descriptor);
+        throw std::runtime_error("cannot map empty or unreadable file "s + path);
+    }
+    
+    size_ = static_cast<size_t>(file_status.st_size);
+    
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    
+    // the mapping stays valid after the descriptor is closed
+    close(file_descriptor);
+    
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("cannot map "s + path);
+    }
+    
+    data_ = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+const char* MappedFile::data() const {
+    return data_;
+}
+
+size_t MappedFile::size() const {
+    return size_;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+// Whole file mapped into memory for reading, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    
+    MappedFile(const MappedFile&) = delete;
+    
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile();
+    
+public:
+    const char* data() const;
+    
+    size_t size() const;
+    
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
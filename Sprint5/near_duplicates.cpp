@@ -0,0 +1,195 @@
+#include "near_duplicates.hpp"
+#include "hashing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace remove_duplicates {
+
+namespace {
+
+constexpr int kSignatureLength = 128;
+
+} // namespace
+
+NearDuplicateDetector::NearDuplicateDetector(double similarity_threshold)
+: NearDuplicateDetector(similarity_threshold,
+                        kSignatureLength / ChooseRowsPerBand(similarity_threshold),
+                        ChooseRowsPerBand(similarity_threshold)) {
+}
+
+NearDuplicateDetector::NearDuplicateDetector(double similarity_threshold, int band_count, int rows_per_band)
+: similarity_threshold_(similarity_threshold)
+, band_count_(band_count)
+, rows_per_band_(rows_per_band)
+, band_buckets_(static_cast<size_t>(std::max(band_count, 0))) {
+    if (!(similarity_threshold > 0.0 && similarity_threshold <= 1.0)) {
+        throw std::invalid_argument("similarity threshold must be in (0, 1]"s);
+    }
+    
+    if (band_count <= 0 || rows_per_band <= 0) {
+        throw std::invalid_argument("band count and rows per band must be positive"s);
+    }
+    
+    hash_seeds_.resize(static_cast<size_t>(band_count * rows_per_band));
+    
+    for (size_t i = 0; i < hash_seeds_.size(); ++i) {
+        hash_seeds_[i] = hashing::Mix(i + 1);
+    }
+}
+
+void NearDuplicateDetector::AddDocument(int document_id, const std::map<std::string_view, double>& word_frequencies) {
+    RemoveDocument(document_id);
+    
+    Signature signature = ComputeSignature(word_frequencies);
+    
+    for (int band = 0; band < band_count_; ++band) {
+        band_buckets_[static_cast<size_t>(band)][ComputeBandKey(signature, band)].push_back(document_id);
+    }
+    
+    document_id_to_signature_.emplace(document_id, std::move(signature));
+}
+
+void NearDuplicateDetector::RemoveDocument(int document_id) {
+    const auto signature_iterator = document_id_to_signature_.find(document_id);
+    
+    if (signature_iterator == document_id_to_signature_.end()) {
+        return;
+    }
+    
+    for (int band = 0; band < band_count_; ++band) {
+        auto& buckets = band_buckets_[static_cast<size_t>(band)];
+        
+        const auto bucket_iterator = buckets.find(ComputeBandKey(signature_iterator->second, band));
+        
+        std::vector<int>& document_ids = bucket_iterator->second;
+        document_ids.erase(std::find(document_ids.begin(), document_ids.end(), document_id));
+        
+        if (document_ids.empty()) {
+            buckets.erase(bucket_iterator);
+        }
+    }
+    
+    document_id_to_signature_.erase(signature_iterator);
+}
+
+std::vector<int> NearDuplicateDetector::FindNearDuplicates(int document_id) const {
+    const Signature& signature = document_id_to_signature_.at(document_id);
+    
+    std::vector<int> candidate_ids;
+    
+    for (int band = 0; band < band_count_; ++band) {
+        const auto& buckets = band_buckets_[static_cast<size_t>(band)];
+        
+        const std::vector<int>& document_ids = buckets.at(ComputeBandKey(signature, band));
+        
+        candidate_ids.insert(candidate_ids.end(), document_ids.begin(), document_ids.end());
+    }
+    
+    std::sort(candidate_ids.begin(), candidate_ids.end());
+    candidate_ids.erase(std::unique(candidate_ids.begin(), candidate_ids.end()), candidate_ids.end());
+    
+    // band collisions only nominate candidates, the whole signature decides
+    candidate_ids.erase(std::remove_if(candidate_ids.begin(), candidate_ids.end(), [&](int candidate_id) {
+        return candidate_id == document_id
+            || EstimateSimilarity(signature, document_id_to_signature_.at(candidate_id)) < similarity_threshold_;
+    }), candidate_ids.end());
+    
+    return candidate_ids;
+}
+
+double NearDuplicateDetector::EstimateSimilarity(int left_document_id, int right_document_id) const {
+    return EstimateSimilarity(document_id_to_signature_.at(left_document_id),
+                              document_id_to_signature_.at(right_document_id));
+}
+
+size_t NearDuplicateDetector::GetDocumentCount() const {
+    return document_id_to_signature_.size();
+}
+
+int NearDuplicateDetector::GetBandCount() const {
+    return band_count_;
+}
+
+int NearDuplicateDetector::GetRowsPerBand() const {
+    return rows_per_band_;
+}
+
+// The candidate probability rises steepest near (1 / bands)^(1 / rows). The most rows keeping that
+// point at or below the threshold reject the most dissimilar pairs while similar ones still collide.
+int NearDuplicateDetector::ChooseRowsPerBand(double similarity_threshold) {
+    int rows_per_band = 1;
+    
+    for (int rows = 2; rows <= kSignatureLength; ++rows) {
+        const int band_count = kSignatureLength / rows;
+        
+        if (std::pow(1.0 / band_count, 1.0 / rows) > similarity_threshold) {
+            break;
+        }
+        
+        rows_per_band = rows;
+    }
+    
+    return rows_per_band;
+}
+
+NearDuplicateDetector::Signature NearDuplicateDetector::ComputeSignature(
+        const std::map<std::string_view, double>& word_frequencies) const {
+    Signature signature(hash_seeds_.size(), std::numeric_limits<uint32_t>::max());
+    
+    for (const auto& [word, term_frequency] : word_frequencies) {
+        const uint64_t word_hash = hashing::HashWord(word);
+        
+        for (size_t i = 0; i < hash_seeds_.size(); ++i) {
+            signature[i] = std::min(signature[i], static_cast<uint32_t>(hashing::Mix(word_hash ^ hash_seeds_[i]) >> 32));
+        }
+    }
+    
+    return signature;
+}
+
+uint64_t NearDuplicateDetector::ComputeBandKey(const Signature& signature, int band) const {
+    uint64_t key = static_cast<uint64_t>(band);
+    
+    const auto band_begin = signature.begin() + band * rows_per_band_;
+    
+    for (auto row = band_begin; row != band_begin + rows_per_band_; ++row) {
+        key = hashing::Mix(key ^ *row);
+    }
+    
+    return key;
+}
+
+double NearDuplicateDetector::EstimateSimilarity(const Signature& left, const Signature& right) const {
+    size_t equal_count = 0;
+    
+    for (size_t i = 0; i < left.size(); ++i) {
+        equal_count += left[i] == right[i];
+    }
+    
+    return static_cast<double>(equal_count) / static_cast<double>(left.size());
+}
+
+std::vector<int> FindNearDuplicates(const SearchServer& search_server, double similarity_threshold) {
+    NearDuplicateDetector detector(similarity_threshold);
+    
+    std::vector<int> duplicate_document_ids;
+    
+    // a document is checked against the documents with smaller ids only
+    for (const int document_id : search_server) {
+        detector.AddDocument(document_id, search_server.GetWordFrequencies(document_id));
+        
+        if (!detector.FindNearDuplicates(document_id).empty()) {
+            detector.RemoveDocument(document_id);
+            duplicate_document_ids.push_back(document_id);
+        }
+    }
+    
+    return duplicate_document_ids;
+}
+
+}
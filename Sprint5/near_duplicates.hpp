@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "search_server.hpp"
+
+namespace remove_duplicates {
+
+// Finds documents whose word sets are similar by Jaccard index, using MinHash signatures
+// split into LSH bands. Documents sharing a band become candidates, candidates are accepted
+// by the similarity estimated from the whole signatures. Documents can be added and removed
+// at any time without rebuilding.
+class NearDuplicateDetector {
+public:
+    // Two documents are near duplicates when the Jaccard index of their word sets is at least
+    // similarity_threshold. Bands and rows are chosen so that pairs at the threshold become
+    // candidates with high probability.
+    explicit NearDuplicateDetector(double similarity_threshold);
+    
+    // More bands find more candidates, more rows per band find fewer. A pair with Jaccard index s
+    // becomes a candidate with probability 1 - (1 - s^rows_per_band)^band_count.
+    NearDuplicateDetector(double similarity_threshold, int band_count, int rows_per_band);
+    
+public:
+    void AddDocument(int document_id, const std::map<std::string_view, double>& word_frequencies);
+    
+    void RemoveDocument(int document_id);
+    
+    // Returns ids of near duplicates of an added document in ascending order, the document itself excluded
+    std::vector<int> FindNearDuplicates(int document_id) const;
+    
+    double EstimateSimilarity(int left_document_id, int right_document_id) const;
+    
+    size_t GetDocumentCount() const;
+    
+    int GetBandCount() const;
+    
+    int GetRowsPerBand() const;
+    
+private:
+    using Signature = std::vector<uint32_t>;
+    
+private:
+    static int ChooseRowsPerBand(double similarity_threshold);
+    
+    Signature ComputeSignature(const std::map<std::string_view, double>& word_frequencies) const;
+    
+    uint64_t ComputeBandKey(const Signature& signature, int band) const;
+    
+    double EstimateSimilarity(const Signature& left, const Signature& right) const;
+    
+private:
+    double similarity_threshold_ = 0.0;
+    int band_count_ = 0;
+    int rows_per_band_ = 0;
+    
+    std::vector<uint64_t> hash_seeds_;
+    
+    std::unordered_map<int, Signature> document_id_to_signature_;
+    
+    // one map per band from the hash of the band to the documents having it
+    std::vector<std::unordered_map<uint64_t, std::vector<int>>> band_buckets_;
+};
+
+// Returns ids of documents which are near duplicates of a document with a smaller id
+std::vector<int> FindNearDuplicates(const SearchServer& search_server, double similarity_threshold);
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <type_traits>
+
+#include "document.hpp"
+
+// Status is kept next to the id so that filtering by it never touches the document table
+struct Posting {
+    int document_id = 0;
+    DocumentStatus status = DocumentStatus::kActual;
+    double term_frequency = 0.0;
+};
+
+// Postings are written to index snapshots as they are laid out in memory
+static_assert(std::is_trivially_copyable_v<Posting> && sizeof(Posting) == 16);
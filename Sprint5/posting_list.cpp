@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <atomic>
+
+#include "posting_list.hpp"
+
+namespace {
+
+bool IsLessById(const Posting& posting, int document_id) {
+    return posting.document_id < document_id;
+}
+
+} // namespace
+
+PostingList::PostingList(const Posting* postings, size_t size, double max_term_frequency, std::shared_ptr<const void> owner)
+: max_term_frequency_(max_term_frequency)
+, borrowed_postings_(postings)
+, borrowed_size_(size)
+, borrowed_postings_owner_(std::move(owner)) {
+}
+
+void PostingList::Add(int document_id, DocumentStatus status, double term_frequency) {
+    UnpackPostings();
+    
+    std::vector<Posting>& postings = *postings_;
+    
+    std::vector<double>& block_max_term_frequencies = *block_max_term_frequencies_;
+    
+    max_term_frequency_ = std::max(max_term_frequency_, term_frequency);
+    
+    // documents usually come with growing ids, so it is a plain append
+    if (postings.empty() || postings.back().document_id < document_id) {
+        if (postings.size() % kBlockSize == 0) {
+            block_max_term_frequencies.push_back(term_frequency);
+        } else {
+            block_max_term_frequencies.back() = std::max(block_max_term_frequencies.back(), term_frequency);
+        }
+        
+        postings.push_back({document_id, status, term_frequency});
+        return;
+    }
+    
+    const auto position = std::lower_bound(postings.begin(), postings.end(), document_id, IsLessById);
+    
+    if (position != postings.end() && position->document_id == document_id) {
+        if (IsRemoved(*position)) {
+            --removed_count_;
+        }
+        
+        position->status = status;
+        position->term_frequency = term_frequency;
+        
+        double& block_max_term_frequency = block_max_term_frequencies[(position - postings.begin()) / kBlockSize];
+        block_max_term_frequency = std::max(block_max_term_frequency, term_frequency);
+        return;
+    }
+    
+    const size_t inserted_position = position - postings.begin();
+    
+    // the postings after it move, so the blocks from it on get new bounds
+    postings.insert(position, {document_id, status, term_frequency});
+    UpdateBlockMaxTermFrequencies(inserted_position);
+} // Add
+
+void PostingList::Remove(int document_id) {
+    UnpackPostings();
+    
+    std::vector<Posting>& postings = *postings_;
+    
+    const auto position = std::lower_bound(postings.begin(), postings.end(), document_id, IsLessById);
+    
+    if (position == postings.end() || position->document_id != document_id || IsRemoved(*position)) {
+        return;
+    }
+    
+    position->term_frequency = kRemovedTermFrequency;
+    ++removed_count_;
+    
+    if (removed_count_ * 2 > postings.size()) {
+        Compact();
+    }
+} // Remove
+
+void PostingList::Remove(const std::vector<int>& document_ids) {
+    UnpackPostings();
+    
+    std::vector<Posting>& postings = *postings_;
+    
+    auto position = postings.begin();
+    
+    for (const int document_id : document_ids) {
+        position = std::lower_bound(position, postings.end(), document_id, IsLessById);
+        
+        if (position == postings.end()) {
+            break;
+        }
+        
+        if (position->document_id == document_id && !IsRemoved(*position)) {
+            position->term_frequency = kRemovedTermFrequency;
+            ++removed_count_;
+        }
+    }
+    
+    if (removed_count_ * 2 > postings.size()) {
+        Compact();
+    }
+} // Remove many
+
+bool PostingList::Contains(int document_id) const {
+    if (IsCompressed()) {
+        Posting posting;
+        
+        return compressed_postings_->Find(document_id, posting);
+    }
+    
+    const Posting* posting = FindPosting(document_id);
+    
+    return posting != nullptr && !IsRemoved(*posting);
+} // Contains
+
+bool PostingList::Find(int document_id, Posting& posting) const {
+    if (IsCompressed()) {
+        return compressed_postings_->Find(document_id, posting);
+    }
+    
+    const Posting* found_posting = FindPosting(document_id);
+    
+    if (found_posting == nullptr || IsRemoved(*found_posting)) {
+        return false;
+    }
+    
+    posting = *found_posting;
+    
+    return true;
+} // Find
+
+size_t PostingList::size() const {
+    if (IsCompressed()) {
+        return compressed_postings_->size();
+    }
+    
+    return static_cast<size_t>(GetPostingsEnd() - GetPostingsBegin()) - removed_count_;
+}
+
+bool PostingList::empty() const {
+    return size() == 0;
+}
+
+void PostingList::Compress() {
+    if (IsCompressed() || empty()) {
+        return;
+    }
+    
+    std::vector<Posting> postings;
+    postings.reserve(size());
+    
+    ForEach([&postings](const Posting& posting) {
+        postings.push_back(posting);
+    });
+    
+    compressed_postings_ = std::make_shared<const CompressedPostings>(postings);
+    
+    // the packed frequencies are rounded, so the bound is taken from them
+    max_term_frequency_ = 0.0;
+    
+    for (size_t block_index = 0; block_index < compressed_postings_->GetBlockCount(); ++block_index) {
+        max_term_frequency_ = std::max(max_term_frequency_,
+                                       static_cast<double>(compressed_postings_->GetBlock(block_index).max_term_frequency));
+    }
+    
+    postings_.reset();
+    block_max_term_frequencies_.reset();
+    removed_count_ = 0;
+    borrowed_postings_ = nullptr;
+    borrowed_size_ = 0;
+    borrowed_postings_owner_.reset();
+} // Compress
+
+size_t PostingList::GetBlockCount() const {
+    if (IsCompressed()) {
+        return compressed_postings_->GetBlockCount();
+    }
+    
+    return (static_cast<size_t>(GetPostingsEnd() - GetPostingsBegin()) + kBlockSize - 1) / kBlockSize;
+}
+
+bool PostingList::IsCompressed() const {
+    return compressed_postings_ != nullptr;
+}
+
+double PostingList::GetMaxTermFrequency() const {
+    return max_term_frequency_;
+}
+
+bool PostingList::IsRemoved(const Posting& posting) {
+    return posting.term_frequency == kRemovedTermFrequency;
+}
+
+const Posting* PostingList::GetPostingsBegin() const {
+    if (borrowed_postings_ != nullptr) {
+        return borrowed_postings_;
+    }
+    
+    return postings_ ? postings_->data() : nullptr;
+}
+
+const Posting* PostingList::GetPostingsEnd() const {
+    if (borrowed_postings_ != nullptr) {
+        return borrowed_postings_ + borrowed_size_;
+    }
+    
+    return postings_ ? postings_->data() + postings_->size() : nullptr;
+}
+
+const Posting* PostingList::FindPosting(int document_id) const {
+    const Posting* position = std::lower_bound(GetPostingsBegin(), GetPostingsEnd(), document_id, IsLessById);
+    
+    if (position != GetPostingsEnd() && position->document_id == document_id) {
+        return position;
+    }
+    
+    return nullptr;
+} // FindPosting
+
+void PostingList::UnpackPostings() {
+    if (IsCompressed()) {
+        auto postings = std::make_shared<std::vector<Posting>>();
+        postings->reserve(compressed_postings_->size());
+        
+        compressed_postings_->ForEach([&postings](const Posting& posting) {
+            postings->push_back(posting);
+        });
+        
+        postings_ = std::move(postings);
+        compressed_postings_.reset();
+        
+        block_max_term_frequencies_ = std::make_shared<std::vector<double>>();
+        UpdateBlockMaxTermFrequencies(0);
+        return;
+    }
+    
+    if (borrowed_postings_ == nullptr) {
+        if (!postings_) {
+            postings_ = std::make_shared<std::vector<Posting>>();
+            block_max_term_frequencies_ = std::make_shared<std::vector<double>>();
+        } else if (postings_.use_count() > 1) {
+            postings_ = std::make_shared<std::vector<Posting>>(*postings_);
+            block_max_term_frequencies_ = std::make_shared<std::vector<double>>(*block_max_term_frequencies_);
+        } else {
+            // the other owners may have just released the postings, their reads must not race with the change
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        
+        return;
+    }
+    
+    postings_ = std::make_shared<std::vector<Posting>>(borrowed_postings_, borrowed_postings_ + borrowed_size_);
+    
+    borrowed_postings_ = nullptr;
+    borrowed_size_ = 0;
+    borrowed_postings_owner_.reset();
+    
+    block_max_term_frequencies_ = std::make_shared<std::vector<double>>();
+    UpdateBlockMaxTermFrequencies(0);
+} // UnpackPostings
+
+void PostingList::Compact() {
+    std::vector<Posting>& postings = *postings_;
+    
+    postings.erase(std::remove_if(postings.begin(), postings.end(), IsRemoved), postings.end());
+    postings.shrink_to_fit();
+    removed_count_ = 0;
+    
+    max_term_frequency_ = 0.0;
+    
+    for (const Posting& posting : postings) {
+        max_term_frequency_ = std::max(max_term_frequency_, posting.term_frequency);
+    }
+    
+    UpdateBlockMaxTermFrequencies(0);
+} // Compact
+
+void PostingList::UpdateBlockMaxTermFrequencies(size_t position) {
+    const std::vector<Posting>& postings = *postings_;
+    std::vector<double>& block_max_term_frequencies = *block_max_term_frequencies_;
+    
+    block_max_term_frequencies.resize((postings.size() + kBlockSize - 1) / kBlockSize);
+    
+    for (size_t block_index = position / kBlockSize; block_index < block_max_term_frequencies.size(); ++block_index) {
+        const auto block_begin = postings.begin() + block_index * kBlockSize;
+        const auto block_end = postings.begin() + std::min(postings.size(), (block_index + 1) * kBlockSize);
+        
+        // removed postings have a negative frequency and so never raise the bound
+        double block_max_term_frequency = 0.0;
+        
+        for (auto posting = block_begin; posting != block_end; ++posting) {
+            block_max_term_frequency = std::max(block_max_term_frequency, posting->term_frequency);
+        }
+        
+        block_max_term_frequencies[block_index] = block_max_term_frequency;
+    }
+} // UpdateBlockMaxTermFrequencies
+
+PostingList::Cursor::Cursor(const PostingList& posting_list): posting_list_(posting_list) {
+    if (posting_list_.IsCompressed()) {
+        LoadBlock(0);
+    } else {
+        end_ = static_cast<size_t>(posting_list_.GetPostingsEnd() - posting_list_.GetPostingsBegin());
+        SkipToLivePosting();
+    }
+}
+
+bool PostingList::Cursor::IsEnd() const {
+    return position_ == end_;
+}
+
+const Posting& PostingList::Cursor::GetPosting() const {
+    return GetPostings()[position_];
+}
+
+void PostingList::Cursor::Next() {
+    ++position_;
+    SkipToLivePosting();
+}
+
+void PostingList::Cursor::Seek(int document_id) {
+    if (IsEnd() || GetPosting().document_id >= document_id) {
+        return;
+    }
+    
+    if (posting_list_.IsCompressed()
+        && posting_list_.compressed_postings_->GetBlock(block_index_).last_document_id < document_id) {
+        LoadBlock(FindBlock(document_id));
+    }
+    
+    const Posting* postings = GetPostings();
+    
+    position_ = std::lower_bound(postings + position_, postings + end_, document_id, IsLessById) - postings;
+    SkipToLivePosting();
+} // Seek
+
+double PostingList::Cursor::GetMaxTermFrequency(int document_id) const {
+    if (IsEnd()) {
+        return 0.0;
+    }
+    
+    if (!posting_list_.IsCompressed()) {
+        if (!posting_list_.block_max_term_frequencies_) {
+            return posting_list_.max_term_frequency_;
+        }
+        
+        const Posting* postings = GetPostings();
+        const size_t position = std::lower_bound(postings + position_, postings + end_, document_id, IsLessById) - postings;
+        
+        return position < end_ ? (*posting_list_.block_max_term_frequencies_)[position / kBlockSize] : 0.0;
+    }
+    
+    const size_t block_index = FindBlock(document_id);
+    const CompressedPostings& compressed_postings = *posting_list_.compressed_postings_;
+    
+    return block_index < compressed_postings.GetBlockCount() ? compressed_postings.GetBlock(block_index).max_term_frequency : 0.0;
+} // GetMaxTermFrequency
+
+const Posting* PostingList::Cursor::GetPostings() const {
+    return posting_list_.IsCompressed() ? block_.data() : posting_list_.GetPostingsBegin();
+}
+
+void PostingList::Cursor::LoadBlock(size_t block_index) {
+    block_index_ = block_index;
+    
+    size_t count = 0;
+    
+    if (block_index < posting_list_.compressed_postings_->GetBlockCount()) {
+        count = posting_list_.compressed_postings_->DecodeBlock(block_index, block_.data());
+    }
+    
+    position_ = 0;
+    end_ = count;
+} // LoadBlock
+
+void PostingList::Cursor::SkipToLivePosting() {
+    if (posting_list_.IsCompressed()) {
+        if (position_ == end_ && block_index_ < posting_list_.compressed_postings_->GetBlockCount()) {
+            LoadBlock(block_index_ + 1);
+        }
+        
+        return;
+    }
+    
+    const Posting* postings = GetPostings();
+    
+    while (position_ != end_ && IsRemoved(postings[position_])) {
+        ++position_;
+    }
+} // SkipToLivePosting
+
+size_t PostingList::Cursor::FindBlock(int document_id) const {
+    const CompressedPostings& compressed_postings = *posting_list_.compressed_postings_;
+    
+    size_t first = block_index_;
+    size_t last = compressed_postings.GetBlockCount();
+    
+    while (first < last) {
+        const size_t middle = first + (last - first) / 2;
+        
+        if (compressed_postings.GetBlock(middle).last_document_id < document_id) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    
+    return first;
+} // FindBlock
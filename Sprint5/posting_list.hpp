@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "posting.hpp"
+#include "compressed_postings.hpp"
+
+// Postings of a single word stored contiguously and sorted by document id.
+// Removed postings are only marked and get erased once they make up half of the list.
+// Every kBlockSize postings keep an upper bound of their term frequencies, packed or not.
+// A list may be packed by Compress, it is unpacked again on the first change.
+// Copies share the postings until one of them is changed
+class PostingList {
+public:
+    class Cursor;
+    
+    static constexpr size_t kBlockSize = CompressedPostings::kBlockSize;
+    
+public:
+    PostingList() = default;
+    
+    // Reads postings in place from memory kept alive by owner, they are copied on the first change.
+    // max_term_frequency is the largest term frequency among the postings, so they are not read here
+    PostingList(const Posting* postings, size_t size, double max_term_frequency, std::shared_ptr<const void> owner);
+    
+public:
+    void Add(int document_id, DocumentStatus status, double term_frequency);
+    
+    void Remove(int document_id);
+    
+    // document_ids must be sorted
+    void Remove(const std::vector<int>& document_ids);
+    
+    bool Contains(int document_id) const;
+    
+    // Returns false if the document is not in the list
+    bool Find(int document_id, Posting& posting) const;
+    
+    size_t size() const;
+    
+    bool empty() const;
+    
+    void Compress();
+    
+    bool IsCompressed() const;
+    
+    // Upper bound of the term frequencies in the list, it is not lowered by removals
+    double GetMaxTermFrequency() const;
+    
+    // Postings are kept in blocks of kBlockSize, removed ones included, so that
+    // ranges of blocks can be read independently
+    size_t GetBlockCount() const;
+    
+    template<typename Function>
+    void ForEach(Function function) const;
+    
+    // Calls function for the live postings of blocks from first_block up to last_block, not including it
+    template<typename Function>
+    void ForEachInBlocks(size_t first_block, size_t last_block, Function function) const;
+    
+private:
+    static constexpr double kRemovedTermFrequency = -1.0;
+    
+private:
+    static bool IsRemoved(const Posting& posting);
+    
+    const Posting* GetPostingsBegin() const;
+    
+    const Posting* GetPostingsEnd() const;
+    
+    const Posting* FindPosting(int document_id) const;
+    
+    // Before a change, moves borrowed or compressed postings to postings_
+    // and copies postings_ if another list shares them
+    void UnpackPostings();
+    
+    void Compact();
+    
+    // Recomputes the bounds of the blocks from the one holding position to the end
+    void UpdateBlockMaxTermFrequencies(size_t position);
+    
+private:
+    // shared with copies of the list, owned alone once the list has been changed
+    std::shared_ptr<std::vector<Posting>> postings_;
+    size_t removed_count_ = 0;
+    double max_term_frequency_ = 0.0;
+    
+    // one bound per kBlockSize postings of postings_, removed ones included, shared together with them
+    std::shared_ptr<std::vector<double>> block_max_term_frequencies_;
+    
+    // set while the postings are read from someone else's memory
+    const Posting* borrowed_postings_ = nullptr;
+    size_t borrowed_size_ = 0;
+    std::shared_ptr<const void> borrowed_postings_owner_;
+    
+    // set while the list is compressed
+    std::shared_ptr<const CompressedPostings> compressed_postings_;
+};
+
+// Walks the live postings of a list in document id order, the list must not change meanwhile
+class PostingList::Cursor {
+public:
+    explicit Cursor(const PostingList& posting_list);
+    
+public:
+    bool IsEnd() const;
+    
+    const Posting& GetPosting() const;
+    
+    void Next();
+    
+    // Moves to the first posting with document id not less than document_id
+    void Seek(int document_id);
+    
+    // Upper bound of the term frequency of the posting of document_id, taken from the block that
+    // would hold it; compressed lists answer it without decoding. Lists read in place from a snapshot
+    // have no block bounds until they change, so the bound of the whole list is returned for them
+    double GetMaxTermFrequency(int document_id) const;
+    
+private:
+    // Decoded block of a compressed list or the postings of an uncompressed one
+    const Posting* GetPostings() const;
+    
+    void LoadBlock(size_t block_index);
+    
+    // Moves to the next block at the end of a compressed one, skips removed postings otherwise
+    void SkipToLivePosting();
+    
+    // Index of the first block from the current one whose last id is not less than document_id
+    size_t FindBlock(int document_id) const;
+    
+private:
+    const PostingList& posting_list_;
+    
+    // offsets rather than pointers, so that a cursor stays valid when it is copied or moved
+    size_t position_ = 0;
+    size_t end_ = 0;
+    
+    // decoded block of a compressed list
+    size_t block_index_ = 0;
+    std::array<Posting, CompressedPostings::kBlockSize> block_;
+};
+
+template<typename Function>
+void PostingList::ForEach(Function function) const {
+    ForEachInBlocks(0, GetBlockCount(), function);
+}
+
+template<typename Function>
+void PostingList::ForEachInBlocks(size_t first_block, size_t last_block, Function function) const {
+    if (IsCompressed()) {
+        compressed_postings_->ForEachInBlocks(first_block, last_block, function);
+        return;
+    }
+    
+    const size_t posting_count = static_cast<size_t>(GetPostingsEnd() - GetPostingsBegin());
+    const Posting* const end = GetPostingsBegin() + std::min(last_block * kBlockSize, posting_count);
+    
+    for (const Posting* posting = GetPostingsBegin() + std::min(first_block * kBlockSize, posting_count); posting != end; ++posting) {
+        if (!IsRemoved(*posting)) {
+            function(*posting);
+        }
+    }
+}
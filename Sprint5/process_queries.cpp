@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <execution>
+#include <exception>
+#include <numeric>
+
+#include "process_queries.hpp"
+
+namespace process_queries {
+
+JoinedDocuments::Iterator::Iterator(const std::vector<std::vector<Document>>* documents, size_t query_index,
+                                    size_t document_index)
+: documents_(documents)
+, query_index_(query_index)
+, document_index_(document_index) {
+    SkipFinishedQueries();
+}
+
+JoinedDocuments::Iterator::reference JoinedDocuments::Iterator::operator*() const {
+    return (*documents_)[query_index_][document_index_];
+}
+
+JoinedDocuments::Iterator::pointer JoinedDocuments::Iterator::operator->() const {
+    return &**this;
+}
+
+JoinedDocuments::Iterator& JoinedDocuments::Iterator::operator++() {
+    ++document_index_;
+    
+    SkipFinishedQueries();
+    
+    return *this;
+}
+
+JoinedDocuments::Iterator JoinedDocuments::Iterator::operator++(int) {
+    Iterator previous = *this;
+    
+    ++*this;
+    
+    return previous;
+}
+
+bool JoinedDocuments::Iterator::operator==(const Iterator& right) const {
+    return documents_ == right.documents_ && query_index_ == right.query_index_
+        && document_index_ == right.document_index_;
+}
+
+bool JoinedDocuments::Iterator::operator!=(const Iterator& right) const {
+    return !(*this == right);
+}
+
+void JoinedDocuments::Iterator::SkipFinishedQueries() {
+    while (query_index_ < documents_->size() && document_index_ == (*documents_)[query_index_].size()) {
+        ++query_index_;
+        document_index_ = 0;
+    }
+}
+
+JoinedDocuments::JoinedDocuments(std::vector<std::vector<Document>> documents): documents_(std::move(documents)) {}
+
+JoinedDocuments::Iterator JoinedDocuments::begin() const {
+    return Iterator(&documents_, 0, 0);
+}
+
+JoinedDocuments::Iterator JoinedDocuments::end() const {
+    return Iterator(&documents_, documents_.size(), 0);
+}
+
+size_t JoinedDocuments::size() const {
+    return std::transform_reduce(documents_.begin(), documents_.end(), size_t{0}, std::plus<>(),
+                                 [](const std::vector<Document>& documents) {
+        return documents.size();
+    });
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                  const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> documents(queries.size());
+    
+    // an exception must not leave a parallel algorithm, so it is carried out and rethrown
+    std::vector<std::exception_ptr> errors(queries.size());
+    
+    std::vector<size_t> query_indexes(queries.size());
+    std::iota(query_indexes.begin(), query_indexes.end(), size_t{0});
+    
+    std::for_each(std::execution::par, query_indexes.begin(), query_indexes.end(), [&](size_t query_index) {
+        try {
+            documents[query_index] = search_server.FindTopDocuments(queries[query_index]);
+        } catch (...) {
+            errors[query_index] = std::current_exception();
+        }
+    });
+    
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    
+    return documents;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
+
+} // namespace process_queries
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iterator>
+
+#include "document.hpp"
+#include "search_server.hpp"
+
+namespace process_queries {
+
+// Documents found for a batch of queries, iterated as one sequence in query order
+// without being copied into a single container
+class JoinedDocuments {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+        
+    public:
+        Iterator(const std::vector<std::vector<Document>>* documents, size_t query_index, size_t document_index);
+        
+    public:
+        reference operator*() const;
+        
+        pointer operator->() const;
+        
+        Iterator& operator++();
+        
+        Iterator operator++(int);
+        
+        bool operator==(const Iterator& right) const;
+        
+        bool operator!=(const Iterator& right) const;
+        
+    private:
+        void SkipFinishedQueries();
+        
+    private:
+        const std::vector<std::vector<Document>>* documents_ = nullptr;
+        size_t query_index_ = 0;
+        size_t document_index_ = 0;
+    };
+    
+public:
+    explicit JoinedDocuments(std::vector<std::vector<Document>> documents);
+    
+public:
+    Iterator begin() const;
+    
+    Iterator end() const;
+    
+    size_t size() const;
+    
+private:
+    std::vector<std::vector<Document>> documents_;
+};
+
+// Queries are evaluated in parallel, results keep the order of queries
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                  const std::vector<std::string>& queries);
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+} // namespace process_queries
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+#include "query_analytics.hpp"
+
+using namespace std::literals;
+
+QueryAnalytics::Pane::Pane(size_t tracked_query_count)
+: queries(tracked_query_count)
+, no_result_queries(tracked_query_count) {}
+
+QueryAnalytics::QueryAnalytics(Clock::duration window_duration, size_t pane_count, size_t tracked_query_count)
+: pane_duration_(pane_count > 0 ? window_duration / static_cast<int64_t>(pane_count) : Clock::duration::zero())
+, panes_(pane_count, Pane(tracked_query_count)) {
+    if (pane_duration_ <= Clock::duration::zero()) {
+        throw std::invalid_argument("analytics window must be split into panes of positive duration"s);
+    }
+}
+
+void QueryAnalytics::Record(Clock::time_point timestamp, std::string_view raw_query, int result_count) {
+    const int64_t pane_number = GetPaneNumber(timestamp);
+    Pane& pane = panes_[static_cast<size_t>(pane_number) % panes_.size()];
+    
+    // a late request whose pane has already been reused for a newer time is dropped
+    if (pane_number < pane.number) {
+        return;
+    }
+    
+    // the pane still holds the requests of a whole window ago
+    if (pane_number > pane.number) {
+        pane.number = pane_number;
+        pane.queries.Clear();
+        pane.no_result_queries.Clear();
+        pane.result_count_histogram.fill(0);
+    }
+    
+    pane.queries.Add(raw_query);
+    
+    if (result_count == 0) {
+        pane.no_result_queries.Add(raw_query);
+    }
+    
+    ++pane.result_count_histogram[std::min(static_cast<size_t>(std::max(result_count, 0)), kHistogramSize - 1)];
+} // Record
+
+std::vector<QueryAnalytics::QueryFrequency> QueryAnalytics::GetTopQueries(Clock::time_point now, size_t query_count) const {
+    return MergeCounters(now, query_count, &Pane::queries);
+}
+
+std::vector<QueryAnalytics::QueryFrequency> QueryAnalytics::GetTopNoResultQueries(Clock::time_point now,
+                                                                                  size_t query_count) const {
+    return MergeCounters(now, query_count, &Pane::no_result_queries);
+}
+
+QueryAnalytics::Histogram QueryAnalytics::GetResultCountHistogram(Clock::time_point now) const {
+    Histogram histogram = {};
+    
+    for (const Pane& pane : panes_) {
+        if (IsInWindow(pane, now)) {
+            for (size_t i = 0; i < kHistogramSize; ++i) {
+                histogram[i] += pane.result_count_histogram[i];
+            }
+        }
+    }
+    
+    return histogram;
+} // GetResultCountHistogram
+
+int64_t QueryAnalytics::GetPaneNumber(Clock::time_point timestamp) const {
+    return timestamp.time_since_epoch() / pane_duration_;
+}
+
+bool QueryAnalytics::IsInWindow(const Pane& pane, Clock::time_point now) const {
+    return pane.number >= 0 && pane.number > GetPaneNumber(now) - static_cast<int64_t>(panes_.size());
+}
+
+std::vector<QueryAnalytics::QueryFrequency> QueryAnalytics::MergeCounters(Clock::time_point now, size_t query_count,
+                                                                          SpaceSavingCounter Pane::* counter) const {
+    struct MergedCount {
+        uint64_t count = 0;
+        // sum of the minimum counts of the panes that track the query
+        uint64_t tracked_min_count = 0;
+    };
+    
+    std::unordered_map<std::string, MergedCount> query_to_count;
+    
+    // a pane that does not track a query may still have seen it up to its minimum count times
+    uint64_t min_count_sum = 0;
+    
+    for (const Pane& pane : panes_) {
+        if (!IsInWindow(pane, now)) {
+            continue;
+        }
+        
+        const uint64_t min_count = (pane.*counter).GetMinCount();
+        min_count_sum += min_count;
+        
+        for (const SpaceSavingCounter::Item& item : (pane.*counter).GetItems()) {
+            MergedCount& merged_count = query_to_count[item.key];
+            merged_count.count += item.count;
+            merged_count.tracked_min_count += min_count;
+        }
+    }
+    
+    std::vector<QueryFrequency> top_queries;
+    top_queries.reserve(query_to_count.size());
+    
+    for (const auto& [query, merged_count] : query_to_count) {
+        top_queries.push_back({query, merged_count.count + min_count_sum - merged_count.tracked_min_count});
+    }
+    
+    // equal counts are ordered by query, so reports are stable
+    const auto result_end = top_queries.begin() + std::min(query_count, top_queries.size());
+    
+    std::partial_sort(top_queries.begin(), result_end, top_queries.end(), [](const QueryFrequency& left, const QueryFrequency& right) {
+        return std::tie(right.count, left.query) < std::tie(left.count, right.query);
+    });
+    
+    top_queries.erase(result_end, top_queries.end());
+    
+    return top_queries;
+} // MergeCounters
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "space_saving_counter.hpp"
+
+// Streaming statistics of the requests of the last window_duration in fixed memory:
+// every pane keeps tracked_query_count queries of at most SpaceSavingCounter::kMaxKeyLength bytes.
+// The window is split into panes with their own counters, a pane is reset when its time
+// comes again, and reports merge the panes still inside the window
+class QueryAnalytics {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    struct QueryFrequency {
+        std::string query;
+        uint64_t count = 0;
+    };
+    
+    // the last bucket counts requests with this or more results
+    static constexpr size_t kHistogramSize = 16;
+    
+    using Histogram = std::array<uint64_t, kHistogramSize>;
+    
+public:
+    QueryAnalytics(Clock::duration window_duration, size_t pane_count, size_t tracked_query_count);
+    
+public:
+    void Record(Clock::time_point timestamp, std::string_view raw_query, int result_count);
+    
+    // Approximate, counts are never underestimated but may be overestimated for rarely requested queries
+    std::vector<QueryFrequency> GetTopQueries(Clock::time_point now, size_t query_count) const;
+    
+    std::vector<QueryFrequency> GetTopNoResultQueries(Clock::time_point now, size_t query_count) const;
+    
+    Histogram GetResultCountHistogram(Clock::time_point now) const;
+    
+private:
+    struct Pane {
+        explicit Pane(size_t tracked_query_count);
+        
+        int64_t number = -1;
+        SpaceSavingCounter queries;
+        SpaceSavingCounter no_result_queries;
+        Histogram result_count_histogram = {};
+    };
+    
+private:
+    int64_t GetPaneNumber(Clock::time_point timestamp) const;
+    
+    bool IsInWindow(const Pane& pane, Clock::time_point now) const;
+    
+    std::vector<QueryFrequency> MergeCounters(Clock::time_point now, size_t query_count,
+                                              SpaceSavingCounter Pane::* counter) const;
+    
+private:
+    Clock::duration pane_duration_;
+    std::vector<Pane> panes_;
+};
@@ -1,37 +1,105 @@
 #include "remove_duplicates.hpp"
+#include "hashing.hpp"
 
-#include <set>
-#include <string>
-#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
-using namespace std::literals;
-
 namespace remove_duplicates {
 
-void RemoveDuplicates(SearchServer& search_server) {
-    std::set<std::set<std::string>> unique_documents;
+namespace {
+
+// 128-bit hash of a sorted set of words, built from two unrelated 64-bit word hashes
+struct WordSetSignature {
+    uint64_t first = 0;
+    uint64_t second = 0;
+    
+    bool operator==(const WordSetSignature& other) const {
+        return first == other.first && second == other.second;
+    }
+};
+
+struct WordSetSignatureHasher {
+    size_t operator()(const WordSetSignature& signature) const {
+        return static_cast<size_t>(signature.first);
+    }
+};
+
+// Polynomial hash with a different multiplier
+uint64_t HashWordSecond(std::string_view word) {
+    uint64_t hash = word.size();
+    
+    for (const char c : word) {
+        hash = hash * 0x9E3779B97F4A7C15ull + static_cast<unsigned char>(c) + 1;
+    }
+    
+    return hash;
+}
+
+WordSetSignature ComputeSignature(const std::map<std::string_view, double>& word_frequencies) {
+    WordSetSignature signature{word_frequencies.size(), ~uint64_t{0}};
+    
+    // words come sorted, so equal sets give equal signatures
+    for (const auto& [word, term_frequency] : word_frequencies) {
+        signature.first = hashing::Mix(signature.first ^ hashing::HashWord(word));
+        signature.second = hashing::Mix(signature.second + HashWordSecond(word));
+    }
+    
+    return signature;
+}
+
+bool HaveSameWords(const std::map<std::string_view, double>& left, const std::map<std::string_view, double>& right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(), [](const auto& left, const auto& right) {
+        return left.first == right.first;
+    });
+}
+
+} // namespace
+
+std::vector<int> FindDuplicates(const SearchServer& search_server) {
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    
+    std::vector<WordSetSignature> signatures(document_ids.size());
+    
+    std::transform(std::execution::par, document_ids.begin(), document_ids.end(), signatures.begin(),
+                   [&search_server](int document_id) {
+        return ComputeSignature(search_server.GetWordFrequencies(document_id));
+    });
+    
+    // words are compared only when signatures collide
+    std::unordered_map<WordSetSignature, std::vector<int>, WordSetSignatureHasher> signature_to_document_ids;
     
     std::vector<int> duplicate_document_ids;
     
-    for (const int document_id : search_server) {
-        const auto words_to_term_frequencies = search_server.GetWordFrequencies(document_id);
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        std::vector<int>& same_signature_document_ids = signature_to_document_ids[signatures[i]];
         
-        std::set<std::string> words_in_document;
+        const auto& word_frequencies = search_server.GetWordFrequencies(document_ids[i]);
         
-        for (const auto& [word, term_frequency] : words_to_term_frequencies) {
-            words_in_document.insert(word);
-        }
+        const bool is_duplicate = std::any_of(same_signature_document_ids.begin(), same_signature_document_ids.end(),
+                                              [&](int document_id) {
+            return HaveSameWords(search_server.GetWordFrequencies(document_id), word_frequencies);
+        });
         
-        if (!unique_documents.insert(words_in_document).second) {
-            duplicate_document_ids.push_back(document_id);
-            std::cout << "Found duplicate document id "s << document_id << std::endl;
+        if (is_duplicate) {
+            duplicate_document_ids.push_back(document_ids[i]);
+        } else {
+            same_signature_document_ids.push_back(document_ids[i]);
         }
     }
     
-    for (const int duplicate_id : duplicate_document_ids) {
-        search_server.RemoveDocument(duplicate_id);
-    }
+    return duplicate_document_ids;
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server) {
+    std::vector<int> duplicate_document_ids = FindDuplicates(search_server);
+    
+    search_server.RemoveDocuments(duplicate_document_ids);
+    
+    return duplicate_document_ids;
 }
 
 }
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <vector>
+
 #include "search_server.hpp"
 
 namespace remove_duplicates {
 
-void RemoveDuplicates(SearchServer& search_server);
+// Returns ids of documents which have the same set of words as a document with a smaller id
+std::vector<int> FindDuplicates(const SearchServer& search_server);
+
+// Removes documents found by FindDuplicates and returns their ids
+std::vector<int> RemoveDuplicates(SearchServer& search_server);
 
 }
@@ -1,32 +1,40 @@
 #include "request_queue.hpp"
 
-RequestQueue::RequestQueue(const SearchServer& search_server): server_(search_server) {}
+RequestQueue::RequestQueue(const SearchServer& search_server, Clock::duration window_duration,
+                           size_t window_capacity, ClockFunction clock)
+: server_(search_server)
+, clock_(std::move(clock))
+, window_(window_duration, window_capacity)
+, analytics_(window_duration, kAnalyticsPaneCount, kTrackedQueryCount) {}
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query,
-                                     DocumentStatus status)  {
-    return AddFindRequest(raw_query, [&status](int, DocumentStatus doc_status, int){
-        return doc_status == status;
-    });
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query,
+                                                   DocumentStatus status)  {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, status);
+    
+    RecordRequest(raw_query, static_cast<int>(results.size()));
+    
+    return results;
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return no_result_requests_counter_;
+    return window_.GetNoResultCount(clock_());
+}
+
+std::vector<QueryAnalytics::QueryFrequency> RequestQueue::GetTopQueries(size_t query_count) const {
+    return analytics_.GetTopQueries(clock_(), query_count);
+}
+
+std::vector<QueryAnalytics::QueryFrequency> RequestQueue::GetTopNoResultQueries(size_t query_count) const {
+    return analytics_.GetTopNoResultQueries(clock_(), query_count);
 }
 
-void RequestQueue::RemoveOutdatedRequests() {
-    if (requests_.size() >= kMinutesInADay) {
-        if(requests_.front().results == 0) {
-            --no_result_requests_counter_;
-        }
-        
-        requests_.pop_front();
-    }
+QueryAnalytics::Histogram RequestQueue::GetResultCountHistogram() const {
+    return analytics_.GetResultCountHistogram(clock_());
 }
 
-void RequestQueue::RecordRequest(const std::string& raw_query, int results) {
-    requests_.push_back(QueryResult(raw_query, results));
+void RequestQueue::RecordRequest(std::string_view raw_query, int result_count) {
+    const Clock::time_point now = clock_();
     
-    if (results == 0) {
-        ++no_result_requests_counter_;
-    }
+    window_.Record(now, result_count);
+    analytics_.Record(now, raw_query, result_count);
 }
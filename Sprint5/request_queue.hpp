@@ -1,52 +1,60 @@
 #pragma once
 
-#include <deque>
+#include <chrono>
+#include <functional>
+#include <string_view>
 #include <vector>
-#include <string>
 
 #include "document.hpp"
 #include "search_server.hpp"
+#include "request_window.hpp"
+#include "query_analytics.hpp"
 
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    using Clock = RequestWindow::Clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+    
+public:
+    // The window covers the last window_duration, but no more than window_capacity latest requests.
+    // Tests pass their own clock to control time
+    explicit RequestQueue(const SearchServer& search_server, Clock::duration window_duration = std::chrono::hours(24),
+                          size_t window_capacity = kDefaultWindowCapacity, ClockFunction clock = Clock::now);
     
 public:
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
     
-    std::vector<Document> AddFindRequest(const std::string& raw_query,
+    std::vector<Document> AddFindRequest(std::string_view raw_query,
                                          DocumentStatus status = DocumentStatus::kActual);
     
     int GetNoResultRequests() const;
     
-private:
-    struct QueryResult {
-        QueryResult(const std::string& raw_query, int results): raw_query(raw_query), results(results) {}
-        
-        const std::string raw_query;
-        const int results;
-    };
+    // Approximate statistics of the requests of the last window duration, regardless of the window capacity
+    std::vector<QueryAnalytics::QueryFrequency> GetTopQueries(size_t query_count) const;
     
-private:
-    static constexpr int kMinutesInADay = 1440;
+    std::vector<QueryAnalytics::QueryFrequency> GetTopNoResultQueries(size_t query_count) const;
+    
+    QueryAnalytics::Histogram GetResultCountHistogram() const;
     
 private:
-    void RemoveOutdatedRequests();
+    static constexpr size_t kDefaultWindowCapacity = 1 << 16;
+    static constexpr size_t kAnalyticsPaneCount = 24;
+    static constexpr size_t kTrackedQueryCount = 64;
     
-    void RecordRequest(const std::string& raw_query, int results);
+private:
+    void RecordRequest(std::string_view raw_query, int result_count);
     
 private:
-    std::deque<QueryResult> requests_;
     const SearchServer& server_;
-    int no_result_requests_counter_ = 0;
+    ClockFunction clock_;
+    RequestWindow window_;
+    QueryAnalytics analytics_;
 };
 
 template <typename DocumentPredicate>
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    RemoveOutdatedRequests();
-    
-    const std::vector<Document>& results = server_.FindTopDocuments(raw_query, document_predicate);
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, document_predicate);
     
     RecordRequest(raw_query, static_cast<int>(results.size()));
     
@@ -0,0 +1,70 @@
+#include <stdexcept>
+
+#include "request_window.hpp"
+
+using namespace std::literals;
+
+RequestWindow::RequestWindow(Clock::duration duration, size_t capacity)
+: duration_(duration)
+, records_(capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("request window must have a positive capacity"s);
+    }
+}
+
+void RequestWindow::Record(Clock::time_point timestamp, int result_count) {
+    while (size_ > 0 && IsExpired(GetRecord(0), timestamp)) {
+        RemoveOldest();
+    }
+    
+    if (size_ == records_.size()) {
+        RemoveOldest();
+    }
+    
+    records_[(first_ + size_) % records_.size()] = {timestamp, result_count};
+    ++size_;
+    
+    if (result_count == 0) {
+        ++no_result_count_;
+    }
+} // Record
+
+int RequestWindow::GetNoResultCount(Clock::time_point now) const {
+    int no_result_count = no_result_count_;
+    
+    // expired records are only dropped by Record, here they are just skipped
+    for (size_t index = 0; index < size_ && IsExpired(GetRecord(index), now); ++index) {
+        if (GetRecord(index).result_count == 0) {
+            --no_result_count;
+        }
+    }
+    
+    return no_result_count;
+} // GetNoResultCount
+
+size_t RequestWindow::GetRequestCount(Clock::time_point now) const {
+    size_t request_count = size_;
+    
+    for (size_t index = 0; index < size_ && IsExpired(GetRecord(index), now); ++index) {
+        --request_count;
+    }
+    
+    return request_count;
+} // GetRequestCount
+
+bool RequestWindow::IsExpired(const RequestRecord& record, Clock::time_point now) const {
+    return now - record.timestamp >= duration_;
+}
+
+const RequestWindow::RequestRecord& RequestWindow::GetRecord(size_t index) const {
+    return records_[(first_ + index) % records_.size()];
+}
+
+void RequestWindow::RemoveOldest() {
+    if (records_[first_].result_count == 0) {
+        --no_result_count_;
+    }
+    
+    first_ = (first_ + 1) % records_.size();
+    --size_;
+} // RemoveOldest
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Requests of the last duration, at most capacity latest of them. Records are kept
+// in a ring buffer allocated once, so recording a request never allocates
+class RequestWindow {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+public:
+    RequestWindow(Clock::duration duration, size_t capacity);
+    
+public:
+    // Timestamps must not decrease from call to call
+    void Record(Clock::time_point timestamp, int result_count);
+    
+    int GetNoResultCount(Clock::time_point now) const;
+    
+    size_t GetRequestCount(Clock::time_point now) const;
+    
+private:
+    struct RequestRecord {
+        Clock::time_point timestamp;
+        int result_count = 0;
+    };
+    
+private:
+    bool IsExpired(const RequestRecord& record, Clock::time_point now) const;
+    
+    const RequestRecord& GetRecord(size_t index) const;
+    
+    void RemoveOldest();
+    
+private:
+    Clock::duration duration_;
+    
+    std::vector<RequestRecord> records_;
+    size_t first_ = 0;
+    size_t size_ = 0;
+    
+    int no_result_count_ = 0;
+};
@@ -0,0 +1,59 @@
+#include "result_cache.hpp"
+
+QueryResultCache::QueryResultCache(size_t capacity): capacity_(capacity) {}
+
+bool QueryResultCache::Find(const std::string& key, uint64_t epoch, std::vector<Document>& result) {
+    std::lock_guard guard(mutex_);
+    
+    const auto entry_iterator = DropStaleEntries(epoch) ? key_to_entry_.find(key) : key_to_entry_.end();
+    
+    if (entry_iterator == key_to_entry_.end()) {
+        ++miss_count_;
+        return false;
+    }
+    
+    entries_.splice(entries_.begin(), entries_, entry_iterator->second);
+    result = entry_iterator->second->result;
+    ++hit_count_;
+    
+    return true;
+} // Find
+
+void QueryResultCache::Insert(const std::string& key, uint64_t epoch, const std::vector<Document>& result) {
+    std::lock_guard guard(mutex_);
+    
+    // a result of an older epoch may miss changes the cached ones already have
+    if (!DropStaleEntries(epoch) || capacity_ == 0 || key_to_entry_.count(key) > 0) {
+        return;
+    }
+    
+    if (entries_.size() == capacity_) {
+        key_to_entry_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+    
+    entries_.push_front({key, result});
+    key_to_entry_.emplace(entries_.front().key, entries_.begin());
+} // Insert
+
+size_t QueryResultCache::GetCapacity() const {
+    return capacity_;
+}
+
+QueryResultCache::Statistics QueryResultCache::GetStatistics() const {
+    std::lock_guard guard(mutex_);
+    
+    return {hit_count_, miss_count_, entries_.size()};
+}
+
+bool QueryResultCache::DropStaleEntries(uint64_t epoch) {
+    if (epoch <= epoch_) {
+        return epoch == epoch_;
+    }
+    
+    key_to_entry_.clear();
+    entries_.clear();
+    epoch_ = epoch;
+    
+    return true;
+} // DropStaleEntries
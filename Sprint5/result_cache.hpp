@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.hpp"
+
+// LRU cache of search results, safe to use from concurrent queries. Results are valid
+// for a single index epoch, the first access with a newer epoch drops all of them.
+// Epochs only move forward: a query still running at an older epoch neither reads nor stores results
+class QueryResultCache {
+public:
+    struct Statistics {
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+        size_t entry_count = 0;
+    };
+    
+public:
+    explicit QueryResultCache(size_t capacity);
+    
+public:
+    // Returns false if there is no result for the key computed at the epoch
+    bool Find(const std::string& key, uint64_t epoch, std::vector<Document>& result);
+    
+    // Does nothing if the epoch is older than the one of the cache
+    void Insert(const std::string& key, uint64_t epoch, const std::vector<Document>& result);
+    
+    size_t GetCapacity() const;
+    
+    Statistics GetStatistics() const;
+    
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> result;
+    };
+    
+private:
+    // Drops all entries when the epoch is newer than the one of the cache,
+    // returns false when it is older
+    bool DropStaleEntries(uint64_t epoch);
+    
+private:
+    const size_t capacity_;
+    
+    mutable std::mutex mutex_;
+    
+    uint64_t epoch_ = 0;
+    
+    // the most recently used entry goes first
+    std::list<Entry> entries_;
+    
+    // keys point to the keys of entries_
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> key_to_entry_;
+    
+    uint64_t hit_count_ = 0;
+    uint64_t miss_count_ = 0;
+};
@@ -3,45 +3,174 @@
 #include <algorithm>
 
 #include "search_server.hpp"
+#include "near_duplicates.hpp"
 #include "string_processing.hpp"
 
 #include "log_duration.h"
 
 using namespace std::literals;
 
-std::set<int>::const_iterator SearchServer::begin() const {
+std::vector<int>::const_iterator SearchServer::begin() const {
     return document_ids_.begin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const {
+std::vector<int>::const_iterator SearchServer::end() const {
     return document_ids_.end();
 }
 
-const std::map<std::string, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    const static std::map<std::string, double> empty_map;
+const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    const static std::map<std::string_view, double> empty_map;
     
-    if (document_id_to_document_data_.count(document_id) > 0) {
-        return document_id_to_document_data_.at(document_id).word_frequencies;
+    const auto ordinal_iterator = document_id_to_ordinal_.find(document_id);
+    
+    if (ordinal_iterator != document_id_to_ordinal_.end()) {
+        return GetDocumentWordFrequencies(ordinal_iterator->second);
     }
     
     return empty_map;
 }
 
+const std::map<std::string_view, double>& SearchServer::GetDocumentWordFrequencies(size_t ordinal) const {
+    WordFrequencies word_frequencies = std::atomic_load(&document_word_frequencies_[ordinal]);
+    
+    if (!word_frequencies) {
+        WordFrequencies stored_word_frequencies;
+        word_frequencies = ReadSnapshotDocumentWords(ordinal_to_document_id_[ordinal]);
+        
+        // concurrent readers of the same document keep the map stored first
+        if (!std::atomic_compare_exchange_strong(&document_word_frequencies_[ordinal], &stored_word_frequencies,
+                                                 word_frequencies)) {
+            word_frequencies = std::move(stored_word_frequencies);
+        }
+    }
+    
+    // the map is held by the entry until the document changes
+    return *word_frequencies;
+} // GetDocumentWordFrequencies
+
 void SearchServer::RemoveDocument(int document_id) {
-    for (const auto& [word, term_frequency] : GetWordFrequencies(document_id)) {
-        word_to_document_id_to_term_frequency_.at(word).erase(document_id);
+    RemoveDocument(std::execution::seq, document_id);
+} // RemoveDocument
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    std::vector<int> removed_document_ids;
+    
+    for (const int document_id : document_ids) {
+        if (document_id_to_ordinal_.count(document_id) > 0) {
+            removed_document_ids.push_back(document_id);
+        }
+    }
+    
+    std::sort(removed_document_ids.begin(), removed_document_ids.end());
+    removed_document_ids.erase(std::unique(removed_document_ids.begin(), removed_document_ids.end()),
+                               removed_document_ids.end());
+    
+    WriteRemovedDocumentsToLog(removed_document_ids);
+    
+    // words refer to the keys of the index, so equal words share the same data
+    std::vector<std::pair<std::string_view, int>> word_to_document_id;
+    
+    for (const int document_id : removed_document_ids) {
+        for (const auto& [word, term_frequency] : GetDocumentWordFrequencies(document_id_to_ordinal_.at(document_id))) {
+            word_to_document_id.emplace_back(word, document_id);
+        }
+    }
+    
+    std::sort(word_to_document_id.begin(), word_to_document_id.end(), [](const auto& left, const auto& right) {
+        return std::pair(left.first.data(), left.second) < std::pair(right.first.data(), right.second);
+    });
+    
+    // every posting list is touched once per batch
+    std::vector<int> word_document_ids;
+    
+    for (auto entry = word_to_document_id.begin(); entry != word_to_document_id.end();) {
+        const std::string_view word = entry->first;
         
-        if (word_to_document_id_to_term_frequency_.at(word).empty()) {
-            word_to_document_id_to_term_frequency_.erase(word);
+        word_document_ids.clear();
+        
+        for (; entry != word_to_document_id.end() && entry->first.data() == word.data(); ++entry) {
+            word_document_ids.push_back(entry->second);
+        }
+        
+        const auto word_iterator = word_to_data_.find(word);
+        
+        word_iterator->second.posting_list.Remove(word_document_ids);
+        
+        if (word_iterator->second.posting_list.empty()) {
+            word_to_data_.erase(word_iterator);
         }
     }
     
-    document_id_to_document_data_.erase(document_id);
+    for (const int document_id : removed_document_ids) {
+        EraseDocumentData(document_id);
+    }
     
-    document_ids_.erase(document_id);
-}
+    document_ids_.erase(std::remove_if(document_ids_.begin(), document_ids_.end(), [&](int document_id) {
+        return std::binary_search(removed_document_ids.begin(), removed_document_ids.end(), document_id);
+    }), document_ids_.end());
+} // RemoveDocuments
+
+void SearchServer::AttachNearDuplicateDetector(std::shared_ptr<remove_duplicates::NearDuplicateDetector> near_duplicate_detector) {
+    for (const int document_id : document_ids_) {
+        near_duplicate_detector->AddDocument(document_id, GetWordFrequencies(document_id));
+    }
+    
+    near_duplicate_detector_ = std::move(near_duplicate_detector);
+} // AttachNearDuplicateDetector
 
-SearchServer::SearchServer(const std::string& stop_words) {
+void SearchServer::SetResultCacheCapacity(size_t capacity) {
+    result_cache_ = capacity > 0 ? std::make_unique<QueryResultCache>(capacity) : nullptr;
+} // SetResultCacheCapacity
+
+QueryResultCache::Statistics SearchServer::GetResultCacheStatistics() const {
+    return result_cache_ ? result_cache_->GetStatistics() : QueryResultCache::Statistics{};
+} // GetResultCacheStatistics
+
+void SearchServer::CompressIndex() {
+    std::vector<PostingList*> posting_lists;
+    posting_lists.reserve(word_to_data_.size());
+    
+    for (auto& [word, word_data] : word_to_data_) {
+        posting_lists.push_back(&word_data.posting_list);
+    }
+    
+    std::for_each(std::execution::par, posting_lists.begin(), posting_lists.end(), [](PostingList* posting_list) {
+        posting_list->Compress();
+    });
+} // CompressIndex
+
+void SearchServer::EraseDocumentData(int document_id) {
+    const size_t ordinal = document_id_to_ordinal_.at(document_id);
+    const size_t last_ordinal = ordinal_to_document_id_.size() - 1;
+    
+    if (ordinal != last_ordinal) {
+        const int moved_document_id = ordinal_to_document_id_[last_ordinal];
+        
+        ordinal_to_document_id_[ordinal] = moved_document_id;
+        document_ratings_[ordinal] = document_ratings_[last_ordinal];
+        document_statuses_[ordinal] = document_statuses_[last_ordinal];
+        document_word_frequencies_[ordinal] = std::move(document_word_frequencies_[last_ordinal]);
+        
+        document_id_to_ordinal_[moved_document_id] = ordinal;
+    }
+    
+    ordinal_to_document_id_.pop_back();
+    document_ratings_.pop_back();
+    document_statuses_.pop_back();
+    document_word_frequencies_.pop_back();
+    
+    document_id_to_ordinal_.erase(document_id);
+    
+    if (near_duplicate_detector_) {
+        near_duplicate_detector_->RemoveDocument(document_id);
+    }
+    
+    ++index_epoch_;
+} // EraseDocumentData
+
+SearchServer::SearchServer(const std::string& stop_words): SearchServer(std::string_view(stop_words)) {}
+
+SearchServer::SearchServer(std::string_view stop_words) {
     if (!IsValidWord(stop_words)) {
         throw std::invalid_argument("stop word contains unaccaptable symbol"s);
     }
@@ -49,95 +178,222 @@ SearchServer::SearchServer(const std::string& stop_words) {
     SetStopWords(stop_words);
 }
 
-void SearchServer::SetStopWords(const std::string& text) {
-    for (const std::string& word : string_processing::SplitIntoWords(text)) {
-        stop_words_.insert(word);
+SearchServer::SearchServer(const SearchServer& other)
+: stop_words_(other.stop_words_)
+, word_to_data_(other.word_to_data_)
+, index_epoch_(other.index_epoch_)
+, document_id_to_ordinal_(other.document_id_to_ordinal_)
+, ordinal_to_document_id_(other.ordinal_to_document_id_)
+, document_ratings_(other.document_ratings_)
+, document_statuses_(other.document_statuses_)
+, document_word_frequencies_(other.document_word_frequencies_.size())
+, snapshot_document_words_(other.snapshot_document_words_)
+, document_ids_(other.document_ids_)
+, last_sequence_number_(other.last_sequence_number_)
+, result_cache_(other.result_cache_ ? std::make_unique<QueryResultCache>(other.result_cache_->GetCapacity()) : nullptr) {
+    // maps of a loaded snapshot may be built by concurrent readers of the other server
+    for (size_t ordinal = 0; ordinal < document_word_frequencies_.size(); ++ordinal) {
+        document_word_frequencies_[ordinal] = std::atomic_load(&other.document_word_frequencies_[ordinal]);
+    }
+} // SearchServer copy constructor
+
+SearchServer& SearchServer::operator=(const SearchServer& other) {
+    if (this != &other) {
+        SearchServer other_copy(other);
+        
+        *this = std::move(other_copy);
     }
+    
+    return *this;
+}
+
+void SearchServer::SetStopWords(std::string_view text) {
+    string_processing::ForEachWord(text, [this](std::string_view word) {
+        stop_words_.emplace(word);
+    });
 } // SetStopWords
 
-bool SearchServer::AddDocument(int document_id, const std::string& document,
+bool SearchServer::AddDocument(int document_id, std::string_view document,
                                DocumentStatus status, const std::vector<int>& ratings) {
-    if (document_id < 0) {
+    const RawDocument raw_document{document_id, document, status, ratings};
+    
+    std::vector<ParsedDocument> parsed_documents;
+    parsed_documents.push_back(ParseDocument(raw_document));
+    
+    WriteAddedDocumentsToLog({raw_document});
+    
+    IndexDocuments(std::move(parsed_documents));
+    
+    return true;
+} // AddDocument
+
+void SearchServer::AddDocuments(const std::vector<RawDocument>& documents) {
+    AddDocuments(std::execution::seq, documents);
+} // AddDocuments
+
+SearchServer::ParsedDocument SearchServer::ParseDocument(const RawDocument& document) const {
+    if (document.id < 0) {
         throw std::invalid_argument("negative ids are not allowed"s);
     }
     
-    if (document_id_to_document_data_.count(document_id) > 0) {
+    if (document_id_to_ordinal_.count(document.id) > 0) {
         throw std::invalid_argument("repeating ids are not allowed"s);
     }
     
-    if (!IsValidWord(document)) {
+    if (!IsValidWord(document.content)) {
         throw std::invalid_argument("word in document contains unaccaptable symbol"s);
     }
     
-    const std::vector<std::string> words = SplitIntoWordsNoStop(document);
+    std::vector<std::string_view> words = SplitIntoWordsNoStop(document.content);
     
     const double inverse_word_count = 1.0 / static_cast<double>(words.size());
     
-    std::map<std::string, double> word_frequencies;
+    std::sort(words.begin(), words.end());
+    
+    ParsedDocument parsed_document{document.id, document.status, ComputeAverageRating(document.ratings), {}};
     
-    for (const std::string& word : words) {
-        word_to_document_id_to_term_frequency_[word][document_id] += inverse_word_count;
-        word_frequencies[word] += inverse_word_count;
+    for (const std::string_view word : words) {
+        if (parsed_document.word_frequencies.empty() || parsed_document.word_frequencies.back().first != word) {
+            parsed_document.word_frequencies.emplace_back(word, 0.0);
+        }
+        
+        parsed_document.word_frequencies.back().second += inverse_word_count;
     }
     
-    document_ids_.insert(document_id);
+    return parsed_document;
+} // ParseDocument
+
+void SearchServer::CheckRepeatingDocumentIds(const std::vector<ParsedDocument>& documents) {
+    std::vector<int> document_ids;
+    document_ids.reserve(documents.size());
     
-    document_id_to_document_data_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, word_frequencies});
+    for (const ParsedDocument& document : documents) {
+        document_ids.push_back(document.id);
+    }
     
-    return true;
-} // AddDocument
-
-int SearchServer::GetDocumentCount() const {
-    return static_cast<int>(document_id_to_document_data_.size());
-} // GetDocumentCount
-
-
+    std::sort(document_ids.begin(), document_ids.end());
+    
+    if (std::adjacent_find(document_ids.begin(), document_ids.end()) != document_ids.end()) {
+        throw std::invalid_argument("repeating ids are not allowed"s);
+    }
+} // CheckRepeatingDocumentIds
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query,
-                                                     const DocumentStatus& desired_status) const {
-    const auto predicate = [desired_status](int , DocumentStatus document_status, int ) {
-        return document_status == desired_status;
+void SearchServer::IndexDocuments(std::vector<ParsedDocument> documents) {
+    std::vector<int> new_document_ids;
+    new_document_ids.reserve(documents.size());
+    
+    for (const ParsedDocument& document : documents) {
+        new_document_ids.push_back(document.id);
+    }
+    
+    std::sort(new_document_ids.begin(), new_document_ids.end());
+    
+    struct WordOccurrence {
+        std::string_view word;
+        size_t document_index = 0;
+        double term_frequency = 0.0;
     };
     
-    return FindTopDocuments(raw_query, predicate);
-} // FindTopDocuments with status as a second argument
-
-std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query, int document_id) const {
-    const Query query = ParseQuery(raw_query);
+    std::vector<WordOccurrence> occurrences;
+    
+    for (size_t document_index = 0; document_index < documents.size(); ++document_index) {
+        for (const auto& [word, term_frequency] : documents[document_index].word_frequencies) {
+            occurrences.push_back({word, document_index, term_frequency});
+        }
+    }
+    
+    std::sort(occurrences.begin(), occurrences.end(), [&documents](const WordOccurrence& left, const WordOccurrence& right) {
+        return std::tie(left.word, documents[left.document_index].id)
+            < std::tie(right.word, documents[right.document_index].id);
+    });
+    
+    // every word is looked up once per batch and only words new to the index are copied,
+    // documents keep views into the index
+    std::vector<std::map<std::string_view, double>> word_frequencies(documents.size());
     
-    std::vector<std::string> matched_words;
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
-            continue;
+    for (auto occurrence = occurrences.begin(); occurrence != occurrences.end();) {
+        const std::string_view word = occurrence->word;
+        
+        auto word_iterator = word_to_data_.find(word);
+        
+        if (word_iterator == word_to_data_.end()) {
+            word_iterator = InsertWord(word_iterator, word, PostingList());
         }
         
-        if (word_to_document_id_to_term_frequency_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+        for (; occurrence != occurrences.end() && occurrence->word == word; ++occurrence) {
+            const ParsedDocument& document = documents[occurrence->document_index];
+            
+            word_iterator->second.posting_list.Add(document.id, document.status, occurrence->term_frequency);
+            
+            auto& document_word_frequencies = word_frequencies[occurrence->document_index];
+            document_word_frequencies.emplace_hint(document_word_frequencies.end(), word_iterator->first,
+                                                   occurrence->term_frequency);
         }
     }
     
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
-            continue;
-        }
+    const auto old_ids_end = document_ids_.insert(document_ids_.end(), new_document_ids.begin(), new_document_ids.end());
+    std::inplace_merge(document_ids_.begin(), old_ids_end, document_ids_.end());
+    
+    for (size_t document_index = 0; document_index < documents.size(); ++document_index) {
+        const ParsedDocument& document = documents[document_index];
         
-        if (word_to_document_id_to_term_frequency_.at(word).count(document_id)) {
-            matched_words.clear();
-            break;
+        document_id_to_ordinal_.emplace(document.id, ordinal_to_document_id_.size());
+        ordinal_to_document_id_.push_back(document.id);
+        document_ratings_.push_back(document.rating);
+        document_statuses_.push_back(document.status);
+        document_word_frequencies_.push_back(std::make_shared<const std::map<std::string_view, double>>(
+            std::move(word_frequencies[document_index])));
+        
+        if (near_duplicate_detector_) {
+            near_duplicate_detector_->AddDocument(document.id, *document_word_frequencies_.back());
         }
     }
     
-    return std::tuple<std::vector<std::string>, DocumentStatus>{matched_words, document_id_to_document_data_.at(document_id).status};
+    ++index_epoch_;
+} // IndexDocuments
+
+SearchServer::WordToData::iterator SearchServer::InsertWord(WordToData::const_iterator hint, std::string_view word,
+                                                           PostingList posting_list) {
+    auto shared_word = std::make_shared<const std::string>(word);
+    const std::string_view key = *shared_word;
+    
+    return word_to_data_.emplace_hint(hint, key, WordData{std::move(shared_word), std::move(posting_list), {}});
+} // InsertWord
+
+int SearchServer::GetDocumentCount() const {
+    return static_cast<int>(ordinal_to_document_id_.size());
+} // GetDocumentCount
+
+
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
+                                                     const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, desired_status, max_result_document_count);
+} // FindTopDocuments with status as a second argument
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return MatchDocument(std::execution::seq, raw_query, document_id);
 } // MatchDocument
 
+std::string_view SearchServer::FindWordInDocument(std::string_view word, int document_id) const {
+    const auto word_iterator = word_to_data_.find(word);
+    
+    if (word_iterator != word_to_data_.end() && word_iterator->second.posting_list.Contains(document_id)) {
+        return word_iterator->first;
+    }
+    
+    return {};
+} // FindWordInDocument
+
 //int SearchServer::GetDocumentId(int index) const {
 //    return document_ids_.at(index);
 //}
 
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string> words;
-    for (const std::string& word : string_processing::SplitIntoWords(text)) {
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+    std::vector<std::string_view> words;
+    for (const std::string_view word : string_processing::SplitIntoWords(text)) {
         if (!IsStopWord(word)) {
             words.push_back(word);
         }
@@ -156,11 +412,19 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 } // ComputeAverageRating
 
-bool SearchServer::IsStopWord(const std::string& word) const {
+bool SearchServer::IsMoreRelevant(const Document& left, const Document& right) {
+    if (std::abs(left.relevance - right.relevance) < kAccuracy) {
+        return left.rating > right.rating;
+    }
+    
+    return left.relevance > right.relevance;
+} // IsMoreRelevant
+
+bool SearchServer::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0;
 } // IsStopWord
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
     if (text.empty()) {
         throw std::invalid_argument("caught empty word, check for double spaces"s);
     }
@@ -168,7 +432,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
     bool is_minus = false;
     
     if (text[0] == '-') {
-        text = text.substr(1);
+        text.remove_prefix(1);
         
         if (text.empty()) {
             throw std::invalid_argument("empty minus words are not allowed"s);
@@ -188,84 +452,109 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
     return {text, is_minus, IsStopWord(text)};
 } // ParseQueryWord
 
-SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
+SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool skip_deduplication) const {
     Query query;
     
-    for (const std::string& word : string_processing::SplitIntoWords(text)) {
+    string_processing::ForEachWord(text, [this, &query](std::string_view word) {
         const QueryWord query_word = ParseQueryWord(word);
         
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
+                query.minus_words.push_back(query_word.data);
             } else {
-                query.plus_words.insert(query_word.data);
+                query.plus_words.push_back(query_word.data);
             }
         }
+    });
+    
+    if (!skip_deduplication) {
+        for (std::vector<std::string_view>* words : {&query.plus_words, &query.minus_words}) {
+            std::sort(words->begin(), words->end());
+            words->erase(std::unique(words->begin(), words->end()), words->end());
+        }
     }
     
     return query;
 } // ParseQuery
 
 // Existence required
-double SearchServer::ComputeWordInverseDocumentFrequency(const std::string& word) const {
-    assert(word_to_document_id_to_term_frequency_.count(word) != 0);
+double SearchServer::GetInverseDocumentFrequency(const WordData& word_data) const {
+    CachedInverseDocumentFrequency& cache = word_data.inverse_document_frequency;
+    
+    // the index does not change while it is queried, so threads racing to refresh store the same value
+    if (cache.epoch.load(std::memory_order_acquire) == index_epoch_) {
+        return cache.value.load(std::memory_order_relaxed);
+    }
     
-    const size_t number_of_documents_constains_word = word_to_document_id_to_term_frequency_.at(word).size();
+    const size_t number_of_documents_constains_word = word_data.posting_list.size();
     
     assert(number_of_documents_constains_word != 0);
     
-    return std::log(static_cast<double>(GetDocumentCount()) / number_of_documents_constains_word);
-} // ComputeWordInverseDocumentFrequency
+    const double inverse_document_frequency = std::log(static_cast<double>(GetDocumentCount()) / number_of_documents_constains_word);
+    
+    cache.value.store(inverse_document_frequency, std::memory_order_relaxed);
+    cache.epoch.store(index_epoch_, std::memory_order_release);
+    
+    return inverse_document_frequency;
+} // GetInverseDocumentFrequency
+
+SearchServer::CachedInverseDocumentFrequency::CachedInverseDocumentFrequency(const CachedInverseDocumentFrequency& other)
+: epoch(other.epoch.load(std::memory_order_acquire))
+, value(other.value.load(std::memory_order_relaxed)) {}
 
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query) const {
-    std::map<int, double> document_id_to_relevance;
+SearchServer::CachedInverseDocumentFrequency&
+SearchServer::CachedInverseDocumentFrequency::operator=(const CachedInverseDocumentFrequency& other) {
+    value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    epoch.store(other.epoch.load(std::memory_order_acquire), std::memory_order_release);
     
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
-            continue;
-        }
-        
-        const double inverse_document_frequency = ComputeWordInverseDocumentFrequency(word);
-        
-        for (const auto &[document_id, term_frequency] : word_to_document_id_to_term_frequency_.at(word)) {
-            document_id_to_relevance[document_id] += term_frequency * inverse_document_frequency;
-        }
-    }
+    return *this;
+}
+
+size_t SearchServer::GetWordDocumentCount(std::string_view word) const {
+    const auto word_iterator = word_to_data_.find(word);
     
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
-            continue;
-        }
-        
-        for (const auto &[document_id, _] : word_to_document_id_to_term_frequency_.at(word)) {
-            document_id_to_relevance.erase(document_id);
-        }
+    return word_iterator != word_to_data_.end() ? word_iterator->second.posting_list.size() : 0;
+} // GetWordDocumentCount
+
+std::string SearchServer::BuildResultCacheKey(const Query& query, DocumentStatus status, int max_result_document_count) {
+    // words cannot contain control characters, so they are safe separators
+    std::string key;
+    
+    for (const std::string_view word : query.plus_words) {
+        key.append(word);
+        key.push_back('\0');
     }
     
-    std::vector<Document> matched_documents;
-    for (const auto &[document_id, relevance] : document_id_to_relevance) {
-        matched_documents.push_back({ document_id, relevance,
-            document_id_to_document_data_.at(document_id).rating});
+    key.push_back('\1');
+    
+    for (const std::string_view word : query.minus_words) {
+        key.append(word);
+        key.push_back('\0');
     }
     
-    return matched_documents;
-} // FindAllDocuments
+    key.push_back('\1');
+    key.append(std::to_string(static_cast<int>(status)));
+    key.push_back('\1');
+    key.append(std::to_string(max_result_document_count));
+    
+    return key;
+} // BuildResultCacheKey
 
-bool SearchServer::IsValidWord(const std::string& word) {
+bool SearchServer::IsValidWord(std::string_view word) {
     // A valid word must not contain special characters
-    return none_of(word.begin(), word.end(), [](char c) {
+    return std::none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
     });
 } // IsValidWord
 
 namespace search_server_helpers {
 
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status) {
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status) {
     std::cout << "{ "s
     << "document_id = "s << document_id << ", "s
     << "status = "s << static_cast<int>(status) << ", "s
     << "words ="s;
-    for (const std::string& word : words) {
+    for (const std::string_view word : words) {
         std::cout << ' ' << word;
     }
     std::cout << "}"s << std::endl;
@@ -280,7 +569,7 @@ void AddDocument(SearchServer& search_server, int document_id, const std::string
     }
 }
 
-void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) {
+void FindTopDocuments(const SearchServer& search_server, std::string_view raw_query) {
     LOG_DURATION("Operation time");
     
     std::cout << "Результаты поиска по запросу: "s << raw_query << std::endl;
@@ -2,14 +2,40 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
+#include <execution>
+#include <type_traits>
+#include <exception>
+#include <numeric>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <cstdint>
 
 #include "document.hpp"
+#include "concurrent_map.hpp"
+#include "posting_list.hpp"
+#include "result_cache.hpp"
+#include "write_ahead_log.hpp"
+
+class ShardQuery;
+
+namespace remove_duplicates {
+class NearDuplicateDetector;
+}
 
 class SearchServer {
+    // shards are queried directly, with document frequencies of the whole corpus
+    friend class ShardQuery;
+    
+public:
+    static constexpr int kMaxResultDocumentCount = 5;
+    
 public:
     SearchServer() = default;
     
@@ -18,78 +44,316 @@ public:
     
     explicit SearchServer(const std::string& stop_words);
     
+    explicit SearchServer(std::string_view stop_words);
+    
+    // The copy shares words, postings and words of documents with the original until either of them
+    // changes them, so copying costs a pass over the dictionary and the document table only.
+    // The copy is not attached to the write-ahead log or the near duplicate detector of the original
+    SearchServer(const SearchServer& other);
+    
+    SearchServer(SearchServer&& other) = default;
+    
+    SearchServer& operator=(const SearchServer& other);
+    
+    SearchServer& operator=(SearchServer&& other) = default;
+    
 public:
-    void SetStopWords(const std::string& text);
+    void SetStopWords(std::string_view text);
     
-    bool AddDocument(int document_id, const std::string& document,
+    bool AddDocument(int document_id, std::string_view document,
                      DocumentStatus status, const std::vector<int>& ratings);
     
+    // Either every document of the batch is added or, if any of them is invalid, none
+    void AddDocuments(const std::vector<RawDocument>& documents);
+    
+    // Documents are parsed in parallel and then merged into the index word by word.
+    // Methods taking a policy accept std::execution::seq and std::execution::par
+    template<typename ExecutionPolicy>
+    void AddDocuments(ExecutionPolicy&& policy, const std::vector<RawDocument>& documents);
+    
     int GetDocumentCount() const;
     
     template<typename Predicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, Predicate predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = kMaxResultDocumentCount) const;
+    
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           const DocumentStatus& desired_status = DocumentStatus::kActual,
+                                           int max_result_document_count = kMaxResultDocumentCount) const;
+    
+    template<typename ExecutionPolicy, typename Predicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = kMaxResultDocumentCount) const;
     
-    std::vector<Document> FindTopDocuments(const std::string& raw_query,
-                                           const DocumentStatus& desired_status = DocumentStatus::kActual) const;
+    template<typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                           const DocumentStatus& desired_status = DocumentStatus::kActual,
+                                           int max_result_document_count = kMaxResultDocumentCount) const;
     
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
+    // Matched words refer to the index and stay valid until the words are removed from it
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
     
-    std::set<int>::const_iterator begin() const;
+    template<typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                                            int document_id) const;
     
-    std::set<int>::const_iterator end() const;
+    std::vector<int>::const_iterator begin() const;
     
-    const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    std::vector<int>::const_iterator end() const;
+    
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
     
     void RemoveDocument(int document_id);
     
+    template<typename ExecutionPolicy>
+    void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+    
+    // Removals are grouped by word, so every posting list is touched once per batch
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    
+    // Results of queries filtered by status are remembered until the index changes,
+    // zero capacity turns the cache off
+    void SetResultCacheCapacity(size_t capacity);
+    
+    QueryResultCache::Statistics GetResultCacheStatistics() const;
+    
+    // Packs every posting list to cut memory and bandwidth of queries, a list is unpacked on its first change
+    void CompressIndex();
+    
+    // Writes the index to a versioned binary file, replacing it only once it is complete
+    void SaveSnapshot(const std::string& path) const;
+    
+    // Maps a snapshot into memory, postings are read from the mapping until they are changed
+    static SearchServer LoadSnapshot(const std::string& path);
+    
+    // Replays the changes logged after the state of the server, then every change
+    // is written to the log and committed before it is applied
+    void AttachWriteAheadLog(std::shared_ptr<WriteAheadLog> write_ahead_log);
+    
+    // Null unless a log is attached
+    std::shared_ptr<WriteAheadLog> GetWriteAheadLog() const;
+    
+    // Adds every document to the detector, which then follows every addition and removal
+    void AttachNearDuplicateDetector(std::shared_ptr<remove_duplicates::NearDuplicateDetector> near_duplicate_detector);
+    
+    // Saves a snapshot and lets the attached log drop the changes it contains in the background.
+    // Throws the error of the previous background compaction, if it failed
+    void Checkpoint(const std::string& snapshot_path) const;
+    
+    // Until FlushDeferredLog, changes are applied without being logged and their records are kept,
+    // so a group of changes to a private copy is logged only once all of them have succeeded.
+    // Does nothing unless a log is attached
+    void DeferWriteAheadLog();
+    
+    // Writes the kept records to the log and commits them at once
+    void FlushDeferredLog();
+    
 private:
-    struct DocumentData {
-        int rating = 0;
-        DocumentStatus status = DocumentStatus::kActual;
-        std::map<std::string, double> word_frequencies;
+    // Words are sorted and unique unless the query was parsed with skip_deduplication
+    struct Query {
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
     };
     
-    struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+    // Words refer to the content of the raw document
+    struct ParsedDocument {
+        int id = 0;
+        DocumentStatus status = DocumentStatus::kActual;
+        int rating = 0;
+        std::vector<std::pair<std::string_view, double>> word_frequencies; // sorted by word
     };
     
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus = false;
         bool is_stop = false;
     };
     
+    // Inverse document frequency together with the index epoch it was computed at.
+    // Concurrent queries may refresh it, so both parts are atomic
+    struct CachedInverseDocumentFrequency {
+        CachedInverseDocumentFrequency() = default;
+        
+        CachedInverseDocumentFrequency(const CachedInverseDocumentFrequency& other);
+        
+        CachedInverseDocumentFrequency& operator=(const CachedInverseDocumentFrequency& other);
+        
+        std::atomic<uint64_t> epoch{kNoEpoch};
+        std::atomic<double> value{0.0};
+    };
+    
+    // Filters check postings while they are scored and documents once their relevance is known.
+    // Unlike a predicate, a status can be a part of a result cache key
+    struct StatusFilter {
+        DocumentStatus status = DocumentStatus::kActual;
+        
+        bool AcceptsPosting(const Posting& posting) const {
+            return posting.status == status;
+        }
+        
+        bool AcceptsDocument(int, DocumentStatus, int) const {
+            return true;
+        }
+    };
+    
+    // A predicate needs the rating, so it is checked once per scored document
+    // together with the rating lookup rather than for every posting
+    template<typename Predicate>
+    struct PredicateFilter {
+        Predicate predicate;
+        
+        bool AcceptsPosting(const Posting&) const {
+            return true;
+        }
+        
+        bool AcceptsDocument(int document_id, DocumentStatus status, int rating) const {
+            return predicate(document_id, status, rating);
+        }
+    };
+    
+    // The word is shared by copies of the index, so views of it stay valid in every copy that has the word
+    struct WordData {
+        std::shared_ptr<const std::string> word;
+        PostingList posting_list;
+        mutable CachedInverseDocumentFrequency inverse_document_frequency;
+    };
+    
+    // keys point to WordData::word
+    using WordToData = std::map<std::string_view, WordData, std::less<>>;
+    
+    // keys point to the words of the index, documents never change, so copies of the index share them
+    using WordFrequencies = std::shared_ptr<const std::map<std::string_view, double>>;
+    
 private:
-    static constexpr int kMaxResultDocumentCount = 5;
     static constexpr double kAccuracy = 1e-6;
+    static constexpr size_t kRelevanceBucketCount = 64;
+    
+    // blocks of postings scored by one task of a parallel search
+    static constexpr size_t kParallelRangeBlockCount = 16;
+    static constexpr uint64_t kNoEpoch = std::numeric_limits<uint64_t>::max();
+    
+    // Parallel paths lock buckets and allocate, which unsequenced policies do not allow
+    template<typename ExecutionPolicy>
+    static constexpr bool kIsSupportedPolicy =
+        std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>
+        || std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>;
     
 private:
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
     
     static int ComputeAverageRating(const std::vector<int>& ratings);
     
-    bool IsStopWord(const std::string& word) const;
+    ParsedDocument ParseDocument(const RawDocument& document) const;
+    
+    // Throws if an id occurs in the batch more than once, checked before the batch is logged
+    static void CheckRepeatingDocumentIds(const std::vector<ParsedDocument>& documents);
+    
+    // Documents must be parsed and checked for repeating ids
+    void IndexDocuments(std::vector<ParsedDocument> documents);
+    
+    WordToData::iterator InsertWord(WordToData::const_iterator hint, std::string_view word, PostingList posting_list);
+    
+    // Documents of a loaded snapshot get their map on first use
+    const std::map<std::string_view, double>& GetDocumentWordFrequencies(size_t ordinal) const;
+    
+    WordFrequencies ReadSnapshotDocumentWords(int document_id) const;
+    
+    // Erases everything but postings and the position in document_ids_
+    void EraseDocumentData(int document_id);
+    
+    static bool IsMoreRelevant(const Document& left, const Document& right);
+    
+    bool IsStopWord(std::string_view word) const;
+    
+    QueryWord ParseQueryWord(std::string_view text) const;
+    
+    Query ParseQuery(std::string_view text, bool skip_deduplication = false) const;
+    
+    // Returns the word as stored in the index, or an empty view if the document does not contain it
+    std::string_view FindWordInDocument(std::string_view word, int document_id) const;
+    
+    // Computed once per index epoch
+    double GetInverseDocumentFrequency(const WordData& word_data) const;
+    
+    template<typename ExecutionPolicy, typename PostingFilter>
+    std::vector<Document> FindTopFilteredDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                   PostingFilter posting_filter, int max_result_document_count) const;
+    
+    // inverse_document_frequency(word, word_data) lets shards rank by frequencies of the whole corpus
+    template<typename ExecutionPolicy, typename PostingFilter, typename InverseDocumentFrequency>
+    std::vector<Document> FindTopQueryDocuments(ExecutionPolicy&& policy, const Query& query,
+                                                PostingFilter posting_filter, int max_result_document_count,
+                                                InverseDocumentFrequency inverse_document_frequency) const;
     
-    QueryWord ParseQueryWord(std::string text) const;
+    template<typename Predicate>
+    static PredicateFilter<Predicate> MakePredicateFilter(Predicate predicate);
+    
+    size_t GetWordDocumentCount(std::string_view word) const;
+    
+    static std::string BuildResultCacheKey(const Query& query, DocumentStatus status, int max_result_document_count);
+    
+    // Same result as scoring every document, but documents that cannot get into it are skipped
+    template<typename PostingFilter, typename InverseDocumentFrequency>
+    std::vector<Document> FindTopDocumentsWithPruning(const Query& query, PostingFilter posting_filter,
+                                                      int max_result_document_count,
+                                                      InverseDocumentFrequency inverse_document_frequency) const;
     
-    Query ParseQuery(const std::string& text) const;
+    template<typename ExecutionPolicy, typename PostingFilter, typename InverseDocumentFrequency>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const Query& query, PostingFilter posting_filter,
+                                           InverseDocumentFrequency inverse_document_frequency) const;
     
-    // Existence required
-    double ComputeWordInverseDocumentFrequency(const std::string& word) const;
+    template<typename PostingFilter>
+    std::vector<Document> BuildMatchedDocuments(const std::map<int, double>& document_id_to_relevance,
+                                                PostingFilter posting_filter) const;
     
-    std::vector<Document> FindAllDocuments(const Query& query) const;
+    static bool IsValidWord(std::string_view word);
     
-    static bool IsValidWord(const std::string& word);
+    // Both do nothing unless a write-ahead log is attached
+    void WriteAddedDocumentsToLog(const std::vector<RawDocument>& documents);
+    
+    void WriteRemovedDocumentsToLog(const std::vector<int>& document_ids);
     
 private:
-    std::set<std::string> stop_words_;
+    std::set<std::string, std::less<>> stop_words_;
+    
+    WordToData word_to_data_;
+    
+    // changed by every addition and removal of documents, which is what invalidates cached values
+    uint64_t index_epoch_ = 0;
+    
+    // documents are stored column-wise and addressed by a dense ordinal,
+    // removal moves the last document into the freed ordinal
+    std::unordered_map<int, size_t> document_id_to_ordinal_;
+    
+    std::vector<int> ordinal_to_document_id_;
+    
+    std::vector<int> document_ratings_;
+    
+    std::vector<DocumentStatus> document_statuses_;
+    
+    // entries of a loaded snapshot stay empty until first read, they are set atomically
+    mutable std::vector<WordFrequencies> document_word_frequencies_;
+    
+    struct SnapshotDocumentWords;
+    
+    std::shared_ptr<const SnapshotDocumentWords> snapshot_document_words_;
+    
+    // sorted, used for iteration
+    std::vector<int> document_ids_;
     
-    std::map<std::string, std::map<int, double>> word_to_document_id_to_term_frequency_;
+    std::shared_ptr<WriteAheadLog> write_ahead_log_;
     
-    std::map<int, DocumentData> document_id_to_document_data_;
+    std::shared_ptr<remove_duplicates::NearDuplicateDetector> near_duplicate_detector_;
     
-    std::set<int> document_ids_;
+    // sequence number of the last logged change contained in the index
+    uint64_t last_sequence_number_ = 0;
+    
+    // copies do not defer, as they are not attached to the log
+    bool is_log_deferred_ = false;
+    std::vector<LogRecord> deferred_log_records_;
+    
+    // copies get an empty cache of the same capacity
+    std::unique_ptr<QueryResultCache> result_cache_;
 };
 
 template <typename StringCollection>
@@ -101,50 +365,531 @@ SearchServer::SearchServer(const StringCollection& stop_words) {
             throw std::invalid_argument("stop word contains unaccaptable symbol"s);
         }
         
-        stop_words_.insert(stop_word);
+        stop_words_.emplace(stop_word);
     }
 }
 
 template<typename Predicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, Predicate predicate) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, predicate, max_result_document_count);
+} // FindTopDocuments
+
+template<typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                     const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
+    // status is stored in postings, so documents with another status are skipped without any lookups
+    return FindTopFilteredDocuments(policy, raw_query, StatusFilter{desired_status}, max_result_document_count);
+} // FindTopDocuments with execution policy and status
+
+template<typename ExecutionPolicy, typename Predicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                     Predicate predicate, int max_result_document_count) const {
+    return FindTopFilteredDocuments(policy, raw_query, MakePredicateFilter(predicate), max_result_document_count);
+} // FindTopDocuments with execution policy
+
+template<typename Predicate>
+SearchServer::PredicateFilter<Predicate> SearchServer::MakePredicateFilter(Predicate predicate) {
+    return PredicateFilter<Predicate>{predicate};
+} // MakePredicateFilter
+
+template<typename ExecutionPolicy, typename PostingFilter>
+std::vector<Document> SearchServer::FindTopFilteredDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                             PostingFilter posting_filter,
+                                                             int max_result_document_count) const {
+    using namespace std::literals;
+    
+    static_assert(kIsSupportedPolicy<ExecutionPolicy>, "only std::execution::seq and std::execution::par are supported");
+    
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+    
     const Query query = ParseQuery(raw_query);
     
-    std::vector<Document> matched_documents = FindAllDocuments(query);
+    const auto inverse_document_frequency = [this](std::string_view, const WordData& word_data) {
+        return GetInverseDocumentFrequency(word_data);
+    };
+    
+    if constexpr (std::is_same_v<PostingFilter, StatusFilter>) {
+        if (result_cache_) {
+            const std::string cache_key = BuildResultCacheKey(query, posting_filter.status, max_result_document_count);
+            
+            const uint64_t index_epoch = index_epoch_;
+            std::vector<Document> result;
+            
+            if (!result_cache_->Find(cache_key, index_epoch, result)) {
+                result = FindTopQueryDocuments(policy, query, posting_filter, max_result_document_count,
+                                               inverse_document_frequency);
+                result_cache_->Insert(cache_key, index_epoch, result);
+            }
+            
+            return result;
+        }
+    }
     
-    std::vector<Document> filtered_documents;
-    for (const Document& document : matched_documents) {
-        const auto document_status = document_id_to_document_data_.at(document.id).status;
-        const auto document_rating = document_id_to_document_data_.at(document.id).rating;
+    return FindTopQueryDocuments(policy, query, posting_filter, max_result_document_count, inverse_document_frequency);
+} // FindTopFilteredDocuments
+
+template<typename ExecutionPolicy, typename PostingFilter, typename InverseDocumentFrequency>
+std::vector<Document> SearchServer::FindTopQueryDocuments(ExecutionPolicy&& policy, const Query& query,
+                                                          PostingFilter posting_filter, int max_result_document_count,
+                                                          InverseDocumentFrequency inverse_document_frequency) const {
+    // a sequential search visits documents one by one and so can skip them,
+    // a parallel one scores every posting of every plus word
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        return FindTopDocumentsWithPruning(query, posting_filter, max_result_document_count, inverse_document_frequency);
+    } else {
+        std::vector<Document> matched_documents = FindAllDocuments(policy, query, posting_filter, inverse_document_frequency);
+        
+        // only the best max_result_document_count documents get ordered, the rest stay in the heap
+        const auto result_end = matched_documents.begin() + std::min(matched_documents.size(),
+                                                                     static_cast<size_t>(max_result_document_count));
         
-        if (predicate(document.id, document_status, document_rating)) {
-            filtered_documents.push_back(document);
+        std::partial_sort(matched_documents.begin(), result_end, matched_documents.end(), IsMoreRelevant);
+        
+        matched_documents.erase(result_end, matched_documents.end());
+        
+        return matched_documents;
+    }
+} // FindTopQueryDocuments
+
+// MaxScore: plus words are ordered by the bound of their contribution, and documents met only in the words
+// whose bounds sum below the current threshold are never visited. Each visited document is dropped
+// as soon as the bounds of its unchecked words, tightened by block maxima, cannot lift it to the threshold.
+// Words found in every document add nothing, so they are not scored: their other documents match
+// with zero relevance and are visited only if the result still has room for such documents
+template<typename PostingFilter, typename InverseDocumentFrequency>
+std::vector<Document> SearchServer::FindTopDocumentsWithPruning(const Query& query, PostingFilter posting_filter,
+                                                                int max_result_document_count,
+                                                                InverseDocumentFrequency inverse_document_frequency) const {
+    struct WordBound {
+        const WordData* word_data = nullptr;
+        double inverse_document_frequency = 0.0;
+        double max_score = 0.0;
+        size_t query_index = 0;
+    };
+    
+    if (max_result_document_count == 0) {
+        return {};
+    }
+    
+    std::vector<WordBound> word_bounds;
+    std::vector<const WordData*> zero_score_words;
+    
+    for (size_t query_index = 0; query_index < query.plus_words.size(); ++query_index) {
+        const auto word_iterator = word_to_data_.find(query.plus_words[query_index]);
+        
+        if (word_iterator == word_to_data_.end()) {
+            continue;
+        }
+        
+        const double word_inverse_document_frequency = inverse_document_frequency(word_iterator->first, word_iterator->second);
+        
+        if (word_inverse_document_frequency == 0.0) {
+            zero_score_words.push_back(&word_iterator->second);
+            continue;
+        }
+        
+        word_bounds.push_back({&word_iterator->second, word_inverse_document_frequency,
+                               word_inverse_document_frequency * word_iterator->second.posting_list.GetMaxTermFrequency(),
+                               query_index});
+    }
+    
+    std::sort(word_bounds.begin(), word_bounds.end(), [](const WordBound& left, const WordBound& right) {
+        return left.max_score < right.max_score;
+    });
+    
+    std::vector<PostingList::Cursor> cursors;
+    cursors.reserve(word_bounds.size());
+    
+    std::vector<double> max_score_prefix_sums;
+    
+    for (const WordBound& word_bound : word_bounds) {
+        cursors.emplace_back(word_bound.word_data->posting_list);
+        max_score_prefix_sums.push_back(word_bound.max_score + (max_score_prefix_sums.empty() ? 0.0 : max_score_prefix_sums.back()));
+    }
+    
+    const auto make_minus_cursors = [this, &query] {
+        std::vector<PostingList::Cursor> minus_cursors;
+        minus_cursors.reserve(query.minus_words.size());
+        
+        for (const std::string_view word : query.minus_words) {
+            const auto word_iterator = word_to_data_.find(word);
+            
+            if (word_iterator != word_to_data_.end()) {
+                minus_cursors.emplace_back(word_iterator->second.posting_list);
+            }
+        }
+        
+        return minus_cursors;
+    };
+    
+    std::vector<PostingList::Cursor> minus_cursors = make_minus_cursors();
+    
+    // documents are visited in increasing order of ids, so cursors only move forward
+    const auto is_in_any = [](std::vector<PostingList::Cursor>& word_cursors, int document_id) {
+        return std::any_of(word_cursors.begin(), word_cursors.end(), [document_id](PostingList::Cursor& cursor) {
+            cursor.Seek(document_id);
+            
+            return !cursor.IsEnd() && cursor.GetPosting().document_id == document_id;
+        });
+    };
+    
+    const size_t result_size = static_cast<size_t>(max_result_document_count);
+    
+    // heap with the least relevant document on top
+    std::vector<Document> top_documents;
+    top_documents.reserve(result_size);
+    
+    const auto add_document = [&top_documents, result_size](const Document& document) {
+        if (top_documents.size() < result_size) {
+            top_documents.push_back(document);
+            std::push_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+        } else if (IsMoreRelevant(document, top_documents.front())) {
+            std::pop_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+            top_documents.back() = document;
+            std::push_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+        }
+    };
+    
+    std::vector<double> contributions(query.plus_words.size());
+    std::vector<double> remaining_max_scores(word_bounds.size());
+    
+    // words before essential_begin cannot bring a document into the result by themselves
+    size_t essential_begin = 0;
+    
+    while (true) {
+        const double threshold = top_documents.size() < result_size ? -std::numeric_limits<double>::infinity()
+                                                                    : top_documents.front().relevance - kAccuracy;
+        
+        while (essential_begin < cursors.size() && max_score_prefix_sums[essential_begin] < threshold) {
+            ++essential_begin;
+        }
+        
+        int document_id = std::numeric_limits<int>::max();
+        bool is_found = false;
+        
+        for (size_t i = essential_begin; i < cursors.size(); ++i) {
+            if (!cursors[i].IsEnd() && cursors[i].GetPosting().document_id <= document_id) {
+                document_id = cursors[i].GetPosting().document_id;
+                is_found = true;
+            }
+        }
+        
+        if (!is_found) {
+            break;
+        }
+        
+        std::fill(contributions.begin(), contributions.end(), 0.0);
+        
+        double score = 0.0;
+        Posting document_posting;
+        
+        for (size_t i = essential_begin; i < cursors.size(); ++i) {
+            if (!cursors[i].IsEnd() && cursors[i].GetPosting().document_id == document_id) {
+                document_posting = cursors[i].GetPosting();
+                
+                contributions[word_bounds[i].query_index] = document_posting.term_frequency * word_bounds[i].inverse_document_frequency;
+                score += contributions[word_bounds[i].query_index];
+                
+                cursors[i].Next();
+            }
+        }
+        
+        double remaining_max_score = 0.0;
+        
+        for (size_t i = 0; i < essential_begin; ++i) {
+            remaining_max_scores[i] = word_bounds[i].inverse_document_frequency * cursors[i].GetMaxTermFrequency(document_id);
+            remaining_max_score += remaining_max_scores[i];
+        }
+        
+        bool is_rejected = score + remaining_max_score < threshold || !posting_filter.AcceptsPosting(document_posting);
+        
+        for (size_t i = essential_begin; i-- > 0 && !is_rejected;) {
+            remaining_max_score -= remaining_max_scores[i];
+            
+            cursors[i].Seek(document_id);
+            
+            if (!cursors[i].IsEnd() && cursors[i].GetPosting().document_id == document_id) {
+                contributions[word_bounds[i].query_index] = cursors[i].GetPosting().term_frequency * word_bounds[i].inverse_document_frequency;
+                score += contributions[word_bounds[i].query_index];
+            }
+            
+            is_rejected = score + remaining_max_score < threshold;
+        }
+        
+        if (is_rejected || is_in_any(minus_cursors, document_id)) {
+            continue;
+        }
+        
+        const size_t ordinal = document_id_to_ordinal_.at(document_id);
+        
+        if (!posting_filter.AcceptsDocument(document_id, document_statuses_[ordinal], document_ratings_[ordinal])) {
+            continue;
+        }
+        
+        // summed in query order, as the exhaustive search does, so relevance is exactly the same
+        const double relevance = std::accumulate(contributions.begin(), contributions.end(), 0.0);
+        add_document(Document(document_id, relevance, document_ratings_[ordinal]));
+    }
+    
+    // a document of zero relevance ties only with a result of less than kAccuracy, and while the threshold
+    // is negative no document has been skipped, so every document of the scored words has been scored already
+    const bool has_room_for_zero_relevance = top_documents.size() < result_size
+                                             || top_documents.front().relevance < kAccuracy;
+    
+    if (!zero_score_words.empty() && has_room_for_zero_relevance) {
+        std::vector<PostingList::Cursor> scored_cursors;
+        scored_cursors.reserve(word_bounds.size());
+        
+        for (const WordBound& word_bound : word_bounds) {
+            scored_cursors.emplace_back(word_bound.word_data->posting_list);
+        }
+        
+        std::vector<PostingList::Cursor> zero_score_cursors;
+        zero_score_cursors.reserve(zero_score_words.size());
+        
+        for (const WordData* word_data : zero_score_words) {
+            zero_score_cursors.emplace_back(word_data->posting_list);
+        }
+        
+        minus_cursors = make_minus_cursors();
+        
+        while (true) {
+            const PostingList::Cursor* next_cursor = nullptr;
+            
+            for (const PostingList::Cursor& cursor : zero_score_cursors) {
+                if (!cursor.IsEnd() && (next_cursor == nullptr
+                                        || cursor.GetPosting().document_id < next_cursor->GetPosting().document_id)) {
+                    next_cursor = &cursor;
+                }
+            }
+            
+            if (next_cursor == nullptr) {
+                break;
+            }
+            
+            const Posting document_posting = next_cursor->GetPosting();
+            const int document_id = document_posting.document_id;
+            
+            for (PostingList::Cursor& cursor : zero_score_cursors) {
+                if (!cursor.IsEnd() && cursor.GetPosting().document_id == document_id) {
+                    cursor.Next();
+                }
+            }
+            
+            if (!posting_filter.AcceptsPosting(document_posting) || is_in_any(scored_cursors, document_id)
+                || is_in_any(minus_cursors, document_id)) {
+                continue;
+            }
+            
+            const size_t ordinal = document_id_to_ordinal_.at(document_id);
+            
+            if (posting_filter.AcceptsDocument(document_id, document_statuses_[ordinal], document_ratings_[ordinal])) {
+                add_document(Document(document_id, 0.0, document_ratings_[ordinal]));
+            }
         }
     }
     
-    std::sort(filtered_documents.begin(), filtered_documents.end(),
-              [](const Document& left, const Document& right) {
-        if (std::abs(left.relevance - right.relevance) < kAccuracy) {
-            return left.rating > right.rating;
-        } else {
-            return left.relevance > right.relevance;
+    std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+    
+    return top_documents;
+} // FindTopDocumentsWithPruning
+
+// Scores every posting of every plus word, used by parallel policies only.
+// Postings rejected by posting_filter never get into the relevance accumulator, documents are checked once summed
+template<typename ExecutionPolicy, typename PostingFilter, typename InverseDocumentFrequency>
+std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query,
+                                                     PostingFilter posting_filter,
+                                                     InverseDocumentFrequency inverse_document_frequency) const {
+    struct PostingRange {
+        const PostingList* posting_list = nullptr;
+        double inverse_document_frequency = 0.0;
+        size_t first_block = 0;
+        size_t last_block = 0;
+    };
+    
+    // posting lists are cut into ranges of blocks, so a long list is traversed by several tasks
+    const auto split_into_ranges = [this, &inverse_document_frequency](const std::vector<std::string_view>& words,
+                                                                       bool is_scored) {
+        std::vector<PostingRange> ranges;
+        
+        for (const std::string_view word : words) {
+            const auto word_iterator = word_to_data_.find(word);
+            
+            if (word_iterator == word_to_data_.end()) {
+                continue;
+            }
+            
+            const PostingList& posting_list = word_iterator->second.posting_list;
+            const double word_inverse_document_frequency = is_scored ? inverse_document_frequency(word_iterator->first, word_iterator->second)
+                                                                     : 0.0;
+            const size_t block_count = posting_list.GetBlockCount();
+            
+            for (size_t first_block = 0; first_block < block_count; first_block += kParallelRangeBlockCount) {
+                ranges.push_back({&posting_list, word_inverse_document_frequency, first_block,
+                                  std::min(first_block + kParallelRangeBlockCount, block_count)});
+            }
         }
+        
+        return ranges;
+    };
+    
+    // relevance is summed into locked buckets
+    ConcurrentMap<int, double> document_id_to_relevance(kRelevanceBucketCount);
+    
+    const std::vector<PostingRange> plus_ranges = split_into_ranges(query.plus_words, true);
+    
+    std::for_each(policy, plus_ranges.begin(), plus_ranges.end(), [&](const PostingRange& range) {
+        range.posting_list->ForEachInBlocks(range.first_block, range.last_block, [&](const Posting& posting) {
+            if (posting_filter.AcceptsPosting(posting)) {
+                document_id_to_relevance[posting.document_id].ref_to_value += posting.term_frequency * range.inverse_document_frequency;
+            }
+        });
     });
     
-    if (static_cast<int>(filtered_documents.size()) > kMaxResultDocumentCount) {
-        filtered_documents.resize(static_cast<size_t>(kMaxResultDocumentCount));
+    const std::vector<PostingRange> minus_ranges = split_into_ranges(query.minus_words, false);
+    
+    std::for_each(policy, minus_ranges.begin(), minus_ranges.end(), [&](const PostingRange& range) {
+        range.posting_list->ForEachInBlocks(range.first_block, range.last_block, [&](const Posting& posting) {
+            document_id_to_relevance.Erase(posting.document_id);
+        });
+    });
+    
+    return BuildMatchedDocuments(document_id_to_relevance.BuildOrdinaryMap(), posting_filter);
+} // FindAllDocuments
+
+template<typename PostingFilter>
+std::vector<Document> SearchServer::BuildMatchedDocuments(const std::map<int, double>& document_id_to_relevance,
+                                                          PostingFilter posting_filter) const {
+    std::vector<Document> matched_documents;
+    
+    for (const auto& [document_id, relevance] : document_id_to_relevance) {
+        const size_t ordinal = document_id_to_ordinal_.at(document_id);
+        
+        if (posting_filter.AcceptsDocument(document_id, document_statuses_[ordinal], document_ratings_[ordinal])) {
+            matched_documents.push_back({document_id, relevance, document_ratings_[ordinal]});
+        }
     }
     
-    return filtered_documents;
-} // FindTopDocuments
+    return matched_documents;
+} // BuildMatchedDocuments
+
+template<typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy,
+                                                                                      std::string_view raw_query,
+                                                                                      int document_id) const {
+    static_assert(kIsSupportedPolicy<ExecutionPolicy>, "only std::execution::seq and std::execution::par are supported");
+    
+    const DocumentStatus status = document_statuses_[document_id_to_ordinal_.at(document_id)];
+    
+    // repeated words are harmless here, matched words get deduplicated once at the end
+    const Query query = ParseQuery(raw_query, true);
+    
+    const auto is_in_document = [this, document_id](std::string_view word) {
+        return !FindWordInDocument(word, document_id).empty();
+    };
+    
+    if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), is_in_document)) {
+        return {std::vector<std::string_view>{}, status};
+    }
+    
+    std::vector<std::string_view> matched_words(query.plus_words.size());
+    
+    std::transform(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+                   [this, document_id](std::string_view word) {
+        return FindWordInDocument(word, document_id);
+    });
+    
+    matched_words.erase(std::remove(matched_words.begin(), matched_words.end(), std::string_view{}), matched_words.end());
+    
+    std::sort(policy, matched_words.begin(), matched_words.end());
+    matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    
+    return {matched_words, status};
+} // MatchDocument with execution policy
+
+template<typename ExecutionPolicy>
+void SearchServer::AddDocuments(ExecutionPolicy&& policy, const std::vector<RawDocument>& documents) {
+    static_assert(kIsSupportedPolicy<ExecutionPolicy>, "only std::execution::seq and std::execution::par are supported");
+    
+    std::vector<ParsedDocument> parsed_documents(documents.size());
+    
+    // an exception must not leave a parallel algorithm, so it is carried out and rethrown
+    std::vector<std::exception_ptr> errors(documents.size());
+    
+    std::vector<size_t> document_indexes(documents.size());
+    std::iota(document_indexes.begin(), document_indexes.end(), size_t{0});
+    
+    std::for_each(policy, document_indexes.begin(), document_indexes.end(), [&](size_t document_index) {
+        try {
+            parsed_documents[document_index] = ParseDocument(documents[document_index]);
+        } catch (...) {
+            errors[document_index] = std::current_exception();
+        }
+    });
+    
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    
+    // a rejected batch must not get into the log, or recovery would reject it again
+    CheckRepeatingDocumentIds(parsed_documents);
+    
+    WriteAddedDocumentsToLog(documents);
+    
+    IndexDocuments(std::move(parsed_documents));
+} // AddDocuments with execution policy
+
+template<typename ExecutionPolicy>
+void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    static_assert(kIsSupportedPolicy<ExecutionPolicy>, "only std::execution::seq and std::execution::par are supported");
+    
+    const auto ordinal_iterator = document_id_to_ordinal_.find(document_id);
+    
+    if (ordinal_iterator == document_id_to_ordinal_.end()) {
+        return;
+    }
+    
+    WriteRemovedDocumentsToLog({document_id});
+    
+    const auto& word_frequencies = GetDocumentWordFrequencies(ordinal_iterator->second);
+    
+    std::vector<WordToData::iterator> word_iterators(word_frequencies.size());
+    
+    std::transform(policy, word_frequencies.begin(), word_frequencies.end(), word_iterators.begin(),
+                   [this](const auto& word_frequency) {
+        return word_to_data_.find(word_frequency.first);
+    });
+    
+    // every word has its own posting list, so they are safe to change in parallel
+    std::for_each(policy, word_iterators.begin(), word_iterators.end(), [document_id](const auto word_iterator) {
+        word_iterator->second.posting_list.Remove(document_id);
+    });
+    
+    for (const auto word_iterator : word_iterators) {
+        if (word_iterator->second.posting_list.empty()) {
+            word_to_data_.erase(word_iterator);
+        }
+    }
+    
+    EraseDocumentData(document_id);
+    
+    document_ids_.erase(std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id));
+} // RemoveDocument with execution policy
 
 namespace search_server_helpers {
 
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status);
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status);
 
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
                  const std::vector<int>& ratings);
 
-void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query);
+void FindTopDocuments(const SearchServer& search_server, std::string_view raw_query);
 
 void MatchDocuments(const SearchServer& search_server, const std::string& query);
 
@@ -0,0 +1,446 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "search_server.hpp"
+#include "mapped_file.hpp"
+#include "file_sync.hpp"
+#include "write_ahead_log.hpp"
+
+using namespace std::literals;
+
+// Snapshot layout, all numbers in the byte order of the machine that wrote it:
+//   SnapshotHeader, including the sequence number of the last logged change in the index
+//   stop words:  uint32 length, bytes
+//   dictionary:  uint32 length, bytes, uint64 index of the first posting, uint64 posting count,
+//                double maximum term frequency
+//   documents:   int32 id, int32 status, int32 rating, uint32 word count
+//   zero padding up to postings_offset
+//   postings:    Posting[posting_count], grouped by word in dictionary order
+//   zero padding up to document_words_offset
+//   words of documents: uint32 dictionary index[posting_count], grouped by document in document order,
+//                ascending within a document
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'S', 'S', 'I', 'N', 'D', 'E', 'X', '\0'};
+constexpr uint32_t kSnapshotVersion = 3;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8] = {};
+    uint32_t version = 0;
+    uint32_t byte_order_mark = 0;
+    uint64_t stop_word_count = 0;
+    uint64_t word_count = 0;
+    uint64_t document_count = 0;
+    uint64_t posting_count = 0;
+    uint64_t postings_offset = 0;
+    uint64_t document_words_offset = 0;
+    uint64_t last_sequence_number = 0;
+};
+
+size_t AlignOffset(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename Value>
+void AppendValue(std::string& buffer, const Value& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendString(std::string& buffer, std::string_view text) {
+    AppendValue(buffer, static_cast<uint32_t>(text.size()));
+    buffer.append(text);
+}
+
+// Bounds-checked reading of a snapshot
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size): data_(data), size_(size) {}
+    
+public:
+    template <typename Value>
+    Value Read() {
+        Value value;
+        std::memcpy(&value, Take(sizeof(value)), sizeof(value));
+        
+        return value;
+    }
+    
+    std::string_view ReadString() {
+        const uint32_t length = Read<uint32_t>();
+        
+        return {Take(length), length};
+    }
+    
+private:
+    const char* Take(size_t count) {
+        if (count > size_ - position_) {
+            throw std::runtime_error("index snapshot is truncated"s);
+        }
+        
+        const char* result = data_ + position_;
+        position_ += count;
+        
+        return result;
+    }
+    
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+};
+
+} // namespace
+
+// Words of the documents of a loaded snapshot, a document's map is built from them on first use
+struct SearchServer::SnapshotDocumentWords {
+    struct DocumentWords {
+        int document_id = 0;
+        uint64_t first_word = 0;
+        uint32_t word_count = 0;
+    };
+    
+    std::shared_ptr<const MappedFile> file;
+    const uint32_t* word_indexes = nullptr;
+    
+    // keys of word_to_data_ by dictionary index
+    std::vector<std::string_view> words;
+    
+    // sorted by document id
+    std::vector<DocumentWords> documents;
+};
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    SnapshotHeader header;
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.byte_order_mark = kByteOrderMark;
+    header.stop_word_count = stop_words_.size();
+    header.word_count = word_to_data_.size();
+    header.document_count = ordinal_to_document_id_.size();
+    header.last_sequence_number = last_sequence_number_;
+    
+    std::string metadata;
+    
+    for (const std::string& stop_word : stop_words_) {
+        AppendString(metadata, stop_word);
+    }
+    
+    // counted first, so every document gets a fixed range of the words section
+    std::vector<uint32_t> document_word_counts(ordinal_to_document_id_.size());
+    
+    for (const auto& [word, word_data] : word_to_data_) {
+        AppendString(metadata, word);
+        AppendValue(metadata, header.posting_count);
+        AppendValue(metadata, static_cast<uint64_t>(word_data.posting_list.size()));
+        AppendValue(metadata, word_data.posting_list.GetMaxTermFrequency());
+        
+        header.posting_count += word_data.posting_list.size();
+        
+        word_data.posting_list.ForEach([this, &document_word_counts](const Posting& posting) {
+            ++document_word_counts[document_id_to_ordinal_.at(posting.document_id)];
+        });
+    }
+    
+    std::vector<uint64_t> document_first_words(ordinal_to_document_id_.size());
+    uint64_t document_word_count = 0;
+    
+    for (size_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+        AppendValue(metadata, static_cast<int32_t>(ordinal_to_document_id_[ordinal]));
+        AppendValue(metadata, static_cast<int32_t>(document_statuses_[ordinal]));
+        AppendValue(metadata, static_cast<int32_t>(document_ratings_[ordinal]));
+        AppendValue(metadata, document_word_counts[ordinal]);
+        
+        document_first_words[ordinal] = document_word_count;
+        document_word_count += document_word_counts[ordinal];
+    }
+    
+    // visiting words in dictionary order keeps the words of every document ascending
+    std::vector<uint32_t> document_words(header.posting_count);
+    uint32_t word_index = 0;
+    
+    for (const auto& [word, word_data] : word_to_data_) {
+        word_data.posting_list.ForEach([this, &document_words, &document_first_words, word_index](const Posting& posting) {
+            document_words[document_first_words[document_id_to_ordinal_.at(posting.document_id)]++] = word_index;
+        });
+        
+        ++word_index;
+    }
+    
+    // postings are aligned, so a mapped snapshot can be read as an array of them
+    const size_t metadata_end = sizeof(header) + metadata.size();
+    header.postings_offset = AlignOffset(metadata_end, alignof(Posting));
+    metadata.append(header.postings_offset - metadata_end, '\0');
+    
+    const size_t postings_end = header.postings_offset + header.posting_count * sizeof(Posting);
+    header.document_words_offset = AlignOffset(postings_end, alignof(uint32_t));
+    
+    // the snapshot replaces the old one only when completely written
+    const std::string temporary_path = path + ".tmp"s;
+    
+    {
+        std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+        
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+        
+        for (const auto& [word, word_data] : word_to_data_) {
+            word_data.posting_list.ForEach([&output](const Posting& posting) {
+                output.write(reinterpret_cast<const char*>(&posting), sizeof(posting));
+            });
+        }
+        
+        const std::string padding(header.document_words_offset - postings_end, '\0');
+        output.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        output.write(reinterpret_cast<const char*>(document_words.data()),
+                     static_cast<std::streamsize>(document_words.size() * sizeof(uint32_t)));
+        
+        output.flush();
+        
+        if (!output) {
+            throw std::runtime_error("cannot write index snapshot "s + temporary_path);
+        }
+    }
+    
+    // the log may drop the changes contained in the snapshot only once the snapshot is durable
+    file_sync::SyncFile(temporary_path);
+    
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("cannot replace index snapshot "s + path);
+    }
+    
+    file_sync::SyncParentDirectory(path);
+} // SaveSnapshot
+
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    const auto file = std::make_shared<const MappedFile>(path);
+    
+    SnapshotReader reader(file->data(), file->size());
+    
+    const auto header = reader.Read<SnapshotHeader>();
+    
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        throw std::runtime_error(path + " is not an index snapshot"s);
+    }
+    
+    if (header.version != kSnapshotVersion || header.byte_order_mark != kByteOrderMark) {
+        throw std::runtime_error("index snapshot "s + path + " has unsupported version or byte order"s);
+    }
+    
+    if (header.postings_offset % alignof(Posting) != 0 || header.postings_offset > file->size()
+        || header.posting_count > (file->size() - header.postings_offset) / sizeof(Posting)) {
+        throw std::runtime_error("index snapshot is truncated"s);
+    }
+    
+    if (header.document_words_offset % alignof(uint32_t) != 0 || header.document_words_offset > file->size()
+        || header.posting_count > (file->size() - header.document_words_offset) / sizeof(uint32_t)) {
+        throw std::runtime_error("index snapshot is truncated"s);
+    }
+    
+    // the mapping is page aligned, so the postings are aligned as well
+    const Posting* postings = reinterpret_cast<const Posting*>(file->data() + header.postings_offset);
+    
+    auto document_words = std::make_shared<SnapshotDocumentWords>();
+    document_words->file = file;
+    document_words->word_indexes = reinterpret_cast<const uint32_t*>(file->data() + header.document_words_offset);
+    document_words->words.reserve(header.word_count);
+    document_words->documents.reserve(header.document_count);
+    
+    SearchServer search_server;
+    search_server.last_sequence_number_ = header.last_sequence_number;
+    
+    for (uint64_t i = 0; i < header.stop_word_count; ++i) {
+        search_server.stop_words_.emplace(reader.ReadString());
+    }
+    
+    for (uint64_t i = 0; i < header.word_count; ++i) {
+        const std::string_view word = reader.ReadString();
+        const auto first_posting = reader.Read<uint64_t>();
+        const auto posting_count = reader.Read<uint64_t>();
+        const auto max_term_frequency = reader.Read<double>();
+        
+        if (first_posting > header.posting_count || posting_count > header.posting_count - first_posting) {
+            throw std::runtime_error("index snapshot is corrupted"s);
+        }
+        
+        const auto word_iterator = search_server.InsertWord(
+            search_server.word_to_data_.end(), word,
+            PostingList(postings + first_posting, posting_count, max_term_frequency, file));
+        
+        document_words->words.push_back(word_iterator->first);
+    }
+    
+    uint64_t document_word_count = 0;
+    
+    for (uint64_t ordinal = 0; ordinal < header.document_count; ++ordinal) {
+        const int document_id = reader.Read<int32_t>();
+        const auto status = static_cast<DocumentStatus>(reader.Read<int32_t>());
+        const int rating = reader.Read<int32_t>();
+        const auto word_count = reader.Read<uint32_t>();
+        
+        if (!search_server.document_id_to_ordinal_.emplace(document_id, ordinal).second
+            || word_count > header.posting_count - document_word_count) {
+            throw std::runtime_error("index snapshot is corrupted"s);
+        }
+        
+        search_server.ordinal_to_document_id_.push_back(document_id);
+        search_server.document_statuses_.push_back(status);
+        search_server.document_ratings_.push_back(rating);
+        
+        document_words->documents.push_back({document_id, document_word_count, word_count});
+        document_word_count += word_count;
+    }
+    
+    search_server.document_ids_ = search_server.ordinal_to_document_id_;
+    std::sort(search_server.document_ids_.begin(), search_server.document_ids_.end());
+    
+    std::sort(document_words->documents.begin(), document_words->documents.end(),
+              [](const auto& left, const auto& right) {
+                  return left.document_id < right.document_id;
+              });
+    
+    // maps of documents are built on first use, so loading does not depend on the number of postings
+    search_server.document_word_frequencies_.resize(header.document_count);
+    search_server.snapshot_document_words_ = std::move(document_words);
+    
+    return search_server;
+} // LoadSnapshot
+
+SearchServer::WordFrequencies SearchServer::ReadSnapshotDocumentWords(int document_id) const {
+    const SnapshotDocumentWords& snapshot = *snapshot_document_words_;
+    
+    const auto document = std::lower_bound(snapshot.documents.begin(), snapshot.documents.end(), document_id,
+                                           [](const auto& document_words, int id) {
+                                               return document_words.document_id < id;
+                                           });
+    
+    // only documents of the snapshot can have no map yet
+    if (document == snapshot.documents.end() || document->document_id != document_id) {
+        throw std::runtime_error("index snapshot is corrupted"s);
+    }
+    
+    auto word_frequencies = std::make_shared<std::map<std::string_view, double>>();
+    
+    for (uint64_t i = document->first_word; i < document->first_word + document->word_count; ++i) {
+        const uint32_t word_index = snapshot.word_indexes[i];
+        Posting posting;
+        
+        if (word_index >= snapshot.words.size()
+            || !word_to_data_.find(snapshot.words[word_index])->second.posting_list.Find(document_id, posting)) {
+            throw std::runtime_error("index snapshot is corrupted"s);
+        }
+        
+        word_frequencies->emplace_hint(word_frequencies->end(), snapshot.words[word_index], posting.term_frequency);
+    }
+    
+    return word_frequencies;
+} // ReadSnapshotDocumentWords
+
+void SearchServer::AttachWriteAheadLog(std::shared_ptr<WriteAheadLog> write_ahead_log) {
+    // changes are replayed before attaching, so they are not logged once more
+    write_ahead_log_.reset();
+    
+    // a log holding nothing newer is not read, so a copy of the server takes over the log cheaply
+    if (write_ahead_log->GetLastSequenceNumber() > last_sequence_number_) {
+        write_ahead_log->Replay(last_sequence_number_, [this](const LogRecord& record) {
+            if (record.operation == LogOperation::kAddDocument) {
+                AddDocument(record.document_id, record.content, record.status, record.ratings);
+            } else {
+                RemoveDocument(record.document_id);
+            }
+            
+            last_sequence_number_ = record.sequence_number;
+        });
+    }
+    
+    write_ahead_log_ = std::move(write_ahead_log);
+} // AttachWriteAheadLog
+
+std::shared_ptr<WriteAheadLog> SearchServer::GetWriteAheadLog() const {
+    return write_ahead_log_;
+}
+
+void SearchServer::Checkpoint(const std::string& snapshot_path) const {
+    // the snapshot would contain changes whose records are not in the log yet
+    if (is_log_deferred_) {
+        throw std::logic_error("checkpoint is not allowed while logging is deferred"s);
+    }
+    
+    SaveSnapshot(snapshot_path);
+    
+    if (write_ahead_log_) {
+        write_ahead_log_->CompactAsync(last_sequence_number_);
+    }
+} // Checkpoint
+
+void SearchServer::WriteAddedDocumentsToLog(const std::vector<RawDocument>& documents) {
+    if (!write_ahead_log_ || documents.empty()) {
+        return;
+    }
+    
+    if (is_log_deferred_) {
+        for (const RawDocument& document : documents) {
+            deferred_log_records_.push_back({0, LogOperation::kAddDocument, document.id, document.status, document.ratings,
+                                             std::string(document.content)});
+        }
+        
+        return;
+    }
+    
+    for (const RawDocument& document : documents) {
+        last_sequence_number_ = write_ahead_log_->AppendAddDocument(document.id, document.content,
+                                                                    document.status, document.ratings);
+    }
+    
+    // one commit covers the whole batch
+    write_ahead_log_->Commit(last_sequence_number_);
+} // WriteAddedDocumentsToLog
+
+void SearchServer::WriteRemovedDocumentsToLog(const std::vector<int>& document_ids) {
+    if (!write_ahead_log_ || document_ids.empty()) {
+        return;
+    }
+    
+    if (is_log_deferred_) {
+        for (const int document_id : document_ids) {
+            deferred_log_records_.push_back({0, LogOperation::kRemoveDocument, document_id, DocumentStatus::kActual, {}, {}});
+        }
+        
+        return;
+    }
+    
+    for (const int document_id : document_ids) {
+        last_sequence_number_ = write_ahead_log_->AppendRemoveDocument(document_id);
+    }
+    
+    write_ahead_log_->Commit(last_sequence_number_);
+} // WriteRemovedDocumentsToLog
+
+void SearchServer::DeferWriteAheadLog() {
+    is_log_deferred_ = write_ahead_log_ != nullptr;
+}
+
+void SearchServer::FlushDeferredLog() {
+    is_log_deferred_ = false;
+    
+    if (deferred_log_records_.empty()) {
+        return;
+    }
+    
+    const std::vector<LogRecord> records = std::move(deferred_log_records_);
+    deferred_log_records_.clear();
+    
+    for (const LogRecord& record : records) {
+        if (record.operation == LogOperation::kAddDocument) {
+            last_sequence_number_ = write_ahead_log_->AppendAddDocument(record.document_id, record.content,
+                                                                        record.status, record.ratings);
+        } else {
+            last_sequence_number_ = write_ahead_log_->AppendRemoveDocument(record.document_id);
+        }
+    }
+    
+    write_ahead_log_->Commit(last_sequence_number_);
+} // FlushDeferredLog
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+#include "shard_query.hpp"
+
+ShardQuery::ShardQuery(const SearchServer& search_server, std::string_view raw_query)
+: query_(search_server.ParseQuery(raw_query))
+, word_document_counts_(query_.plus_words.size(), 0) {
+}
+
+void ShardQuery::AddShardStatistics(const SearchServer& shard) {
+    document_count_ += shard.GetDocumentCount();
+    
+    for (size_t i = 0; i < query_.plus_words.size(); ++i) {
+        word_document_counts_[i] += shard.GetWordDocumentCount(query_.plus_words[i]);
+    }
+} // AddShardStatistics
+
+std::vector<Document> ShardQuery::FindTopDocuments(const SearchServer& shard, DocumentStatus desired_status,
+                                                   int max_result_document_count) const {
+    return FindTopFilteredDocuments(shard, SearchServer::StatusFilter{desired_status}, max_result_document_count);
+}
+
+std::string ShardQuery::GetResultCacheKey(DocumentStatus desired_status, int max_result_document_count) const {
+    return SearchServer::BuildResultCacheKey(query_, desired_status, max_result_document_count);
+}
+
+std::vector<Document> ShardQuery::MergeTopDocuments(const std::vector<std::vector<Document>>& shard_results,
+                                                    int max_result_document_count) {
+    // positions in the sorted results of the shards, the most relevant current document on top
+    using Position = std::pair<size_t, size_t>;
+    
+    const auto is_less_relevant = [&shard_results](const Position& left, const Position& right) {
+        return SearchServer::IsMoreRelevant(shard_results[right.first][right.second], shard_results[left.first][left.second]);
+    };
+    
+    std::priority_queue<Position, std::vector<Position>, decltype(is_less_relevant)> positions(is_less_relevant);
+    
+    for (size_t shard_index = 0; shard_index < shard_results.size(); ++shard_index) {
+        if (!shard_results[shard_index].empty()) {
+            positions.push({shard_index, 0});
+        }
+    }
+    
+    std::vector<Document> result;
+    
+    while (!positions.empty() && result.size() < static_cast<size_t>(max_result_document_count)) {
+        const auto [shard_index, document_index] = positions.top();
+        positions.pop();
+        
+        result.push_back(shard_results[shard_index][document_index]);
+        
+        if (document_index + 1 < shard_results[shard_index].size()) {
+            positions.push({shard_index, document_index + 1});
+        }
+    }
+    
+    return result;
+} // MergeTopDocuments
+
+double ShardQuery::GetInverseDocumentFrequency(std::string_view word) const {
+    const auto word_position = std::lower_bound(query_.plus_words.begin(), query_.plus_words.end(), word);
+    
+    // a word found in a shard but not counted belongs to a document added meanwhile
+    const size_t word_document_count = std::max<size_t>(word_document_counts_[word_position - query_.plus_words.begin()], 1);
+    const size_t document_count = std::max(static_cast<size_t>(document_count_), word_document_count);
+    
+    // the same expression as in a single server, so the values are bit for bit equal
+    return std::log(static_cast<double>(document_count) / word_document_count);
+} // GetInverseDocumentFrequency
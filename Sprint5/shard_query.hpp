@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.hpp"
+#include "search_server.hpp"
+
+// Query run over several SearchServer shards with the document counts of all of them, so that
+// every shard ranks its documents as a single server holding the whole corpus would.
+// It is the only access other classes have to the query internals of SearchServer
+class ShardQuery {
+public:
+    // Words of the query refer to raw_query, which has to outlive the query. Shards must share stop words
+    ShardQuery(const SearchServer& search_server, std::string_view raw_query);
+    
+public:
+    // Counts the documents of a shard, called for every shard before any of them is searched
+    void AddShardStatistics(const SearchServer& shard);
+    
+    // Results are sorted by relevance, the same way as the results of SearchServer
+    std::vector<Document> FindTopDocuments(const SearchServer& shard, DocumentStatus desired_status,
+                                           int max_result_document_count) const;
+    
+    template<typename Predicate>
+    std::vector<Document> FindTopDocuments(const SearchServer& shard, Predicate predicate,
+                                           int max_result_document_count) const;
+    
+    // Key of the query in a QueryResultCache
+    std::string GetResultCacheKey(DocumentStatus desired_status, int max_result_document_count) const;
+    
+    // Merges the sorted results of shards into the best max_result_document_count documents
+    static std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& shard_results,
+                                                   int max_result_document_count);
+    
+private:
+    // Never negative or infinite, even if a shard got a document after its statistics were taken
+    double GetInverseDocumentFrequency(std::string_view word) const;
+    
+    template<typename PostingFilter>
+    std::vector<Document> FindTopFilteredDocuments(const SearchServer& shard, PostingFilter posting_filter,
+                                                   int max_result_document_count) const;
+    
+private:
+    SearchServer::Query query_;
+    
+    int document_count_ = 0;
+    
+    // counts of documents containing the plus words, in the order of the words
+    std::vector<size_t> word_document_counts_;
+};
+
+template<typename Predicate>
+std::vector<Document> ShardQuery::FindTopDocuments(const SearchServer& shard, Predicate predicate,
+                                                   int max_result_document_count) const {
+    return FindTopFilteredDocuments(shard, shard.MakePredicateFilter(predicate), max_result_document_count);
+} // FindTopDocuments with predicate
+
+template<typename PostingFilter>
+std::vector<Document> ShardQuery::FindTopFilteredDocuments(const SearchServer& shard, PostingFilter posting_filter,
+                                                           int max_result_document_count) const {
+    const auto inverse_document_frequency = [this](std::string_view word, const auto&) {
+        return GetInverseDocumentFrequency(word);
+    };
+    
+    // shards are searched in parallel already, so each of them is searched sequentially with pruning
+    return shard.FindTopQueryDocuments(std::execution::seq, query_, posting_filter, max_result_document_count,
+                                       inverse_document_frequency);
+} // FindTopFilteredDocuments
@@ -0,0 +1,71 @@
+#include <stdexcept>
+
+#include "sharded_search_server.hpp"
+
+using namespace std::literals;
+
+ShardedSearchServer::ShardedSearchServer(std::string_view stop_words, size_t shard_count) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("at least one shard is required"s);
+    }
+    
+    shards_.reserve(shard_count);
+    
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.emplace_back(stop_words);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                      const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("negative ids are not allowed"s);
+    }
+    
+    shards_[GetShardIndex(document_id)].AddDocument(document_id, document, status, ratings);
+} // AddDocument
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    if (document_id >= 0) {
+        shards_[GetShardIndex(document_id)].RemoveDocument(document_id);
+    }
+} // RemoveDocument
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    
+    for (const SearchServer& shard : shards_) {
+        document_count += shard.GetDocumentCount();
+    }
+    
+    return document_count;
+} // GetDocumentCount
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus desired_status,
+                                                            int max_result_document_count) const {
+    return FindTopShardDocuments(raw_query, [desired_status, max_result_document_count](const ShardQuery& query,
+                                                                                         const SearchServer& shard) {
+        return query.FindTopDocuments(shard, desired_status, max_result_document_count);
+    }, max_result_document_count);
+} // FindTopDocuments
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(std::string_view raw_query,
+                                                                                             int document_id) const {
+    if (document_id < 0) {
+        throw std::out_of_range("document "s + std::to_string(document_id) + " is not found"s);
+    }
+    
+    return shards_[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+} // MatchDocument
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t shard_index) const {
+    return shards_.at(shard_index);
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    return static_cast<size_t>(document_id) % shards_.size();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <execution>
+#include <exception>
+#include <numeric>
+
+#include "document.hpp"
+#include "search_server.hpp"
+#include "shard_query.hpp"
+
+// Documents split across SearchServer shards by id. Queries go to all shards in parallel,
+// with inverse document frequencies of the whole corpus, so relevance is exactly the same
+// as in a single server; the sorted results of the shards are merged with a heap
+class ShardedSearchServer {
+public:
+    ShardedSearchServer(std::string_view stop_words, size_t shard_count);
+    
+public:
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    
+    void RemoveDocument(int document_id);
+    
+    int GetDocumentCount() const;
+    
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           DocumentStatus desired_status = DocumentStatus::kActual,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    template<typename Predicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+    
+    size_t GetShardCount() const;
+    
+    const SearchServer& GetShard(size_t shard_index) const;
+    
+private:
+    size_t GetShardIndex(int document_id) const;
+    
+    // find_shard_documents(query, shard) searches a single shard
+    template<typename FindShardDocuments>
+    std::vector<Document> FindTopShardDocuments(std::string_view raw_query, FindShardDocuments find_shard_documents,
+                                                int max_result_document_count) const;
+    
+private:
+    std::vector<SearchServer> shards_;
+};
+
+template<typename Predicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                                            int max_result_document_count) const {
+    return FindTopShardDocuments(raw_query, [&predicate, max_result_document_count](const ShardQuery& query,
+                                                                                    const SearchServer& shard) {
+        return query.FindTopDocuments(shard, predicate, max_result_document_count);
+    }, max_result_document_count);
+} // FindTopDocuments with predicate
+
+template<typename FindShardDocuments>
+std::vector<Document> ShardedSearchServer::FindTopShardDocuments(std::string_view raw_query,
+                                                                 FindShardDocuments find_shard_documents,
+                                                                 int max_result_document_count) const {
+    using namespace std::literals;
+    
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+    
+    // shards share stop words, so any of them parses the query the same way
+    ShardQuery query(shards_.front(), raw_query);
+    
+    for (const SearchServer& shard : shards_) {
+        query.AddShardStatistics(shard);
+    }
+    
+    std::vector<std::vector<Document>> shard_results(shards_.size());
+    
+    // an exception must not leave a parallel algorithm, so it is carried out and rethrown
+    std::vector<std::exception_ptr> errors(shards_.size());
+    
+    std::vector<size_t> shard_indexes(shards_.size());
+    std::iota(shard_indexes.begin(), shard_indexes.end(), size_t{0});
+    
+    std::for_each(std::execution::par, shard_indexes.begin(), shard_indexes.end(), [&](size_t shard_index) {
+        try {
+            shard_results[shard_index] = find_shard_documents(query, shards_[shard_index]);
+        } catch (...) {
+            errors[shard_index] = std::current_exception();
+        }
+    });
+    
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    
+    return ShardQuery::MergeTopDocuments(shard_results, max_result_document_count);
+} // FindTopShardDocuments
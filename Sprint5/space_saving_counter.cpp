@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "space_saving_counter.hpp"
+
+using namespace std::literals;
+
+SpaceSavingCounter::SpaceSavingCounter(size_t capacity): capacity_(capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("space saving counter must have a positive capacity"s);
+    }
+    
+    items_.reserve(capacity);
+}
+
+void SpaceSavingCounter::Add(std::string_view key) {
+    key = key.substr(0, kMaxKeyLength);
+    
+    const auto index_iterator = key_to_index_.find(key);
+    
+    if (index_iterator != key_to_index_.end()) {
+        ++items_[index_iterator->second].count;
+        SiftDown(index_iterator->second);
+        return;
+    }
+    
+    if (items_.size() < capacity_) {
+        // a new key has the least possible count, so it rises towards the top
+        items_.push_back({std::string(key), 1, 0});
+        key_to_index_.emplace(key, items_.size() - 1);
+        
+        for (size_t index = items_.size() - 1; index > 0 && items_[(index - 1) / 2].count > items_[index].count;) {
+            SwapItems(index, (index - 1) / 2);
+            index = (index - 1) / 2;
+        }
+        
+        return;
+    }
+    
+    // the least counted key gives its place away, its map node is reused for the new key
+    auto key_node = key_to_index_.extract(items_[0].key);
+    key_node.key().assign(key);
+    key_to_index_.insert(std::move(key_node));
+    
+    Item& item = items_[0];
+    item.key.assign(key);
+    item.error = item.count;
+    ++item.count;
+    
+    SiftDown(0);
+} // Add
+
+void SpaceSavingCounter::Clear() {
+    items_.clear();
+    key_to_index_.clear();
+}
+
+std::vector<SpaceSavingCounter::Item> SpaceSavingCounter::GetItems() const {
+    std::vector<Item> items = items_;
+    
+    std::sort(items.begin(), items.end(), [](const Item& left, const Item& right) {
+        return left.count > right.count;
+    });
+    
+    return items;
+} // GetItems
+
+uint64_t SpaceSavingCounter::GetMinCount() const {
+    return items_.size() < capacity_ ? 0 : items_[0].count;
+}
+
+void SpaceSavingCounter::SiftDown(size_t index) {
+    while (true) {
+        size_t smallest_index = index;
+        
+        for (const size_t child_index : {2 * index + 1, 2 * index + 2}) {
+            if (child_index < items_.size() && items_[child_index].count < items_[smallest_index].count) {
+                smallest_index = child_index;
+            }
+        }
+        
+        if (smallest_index == index) {
+            return;
+        }
+        
+        SwapItems(index, smallest_index);
+        index = smallest_index;
+    }
+} // SiftDown
+
+void SpaceSavingCounter::SwapItems(size_t left_index, size_t right_index) {
+    std::swap(items_[left_index], items_[right_index]);
+    
+    key_to_index_.find(items_[left_index].key)->second = left_index;
+    key_to_index_.find(items_[right_index].key)->second = right_index;
+} // SwapItems
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Approximate counts of the most frequent keys of a stream in fixed memory (Space-Saving).
+// A key missing from the full counter replaces the least counted one and inherits its count,
+// so counts are overestimated by at most the error of the item. Keys are cut to kMaxKeyLength
+// bytes, so the memory is bounded by capacity keys of that length and longer keys sharing
+// a prefix are counted together
+class SpaceSavingCounter {
+public:
+    static constexpr size_t kMaxKeyLength = 256;
+    
+    struct Item {
+        std::string key;
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+    
+public:
+    explicit SpaceSavingCounter(size_t capacity);
+    
+public:
+    void Add(std::string_view key);
+    
+    void Clear();
+    
+    // Items by decreasing count
+    std::vector<Item> GetItems() const;
+    
+    // Upper bound of the count of a key that is not among the items: zero until the counter is full
+    uint64_t GetMinCount() const;
+    
+private:
+    void SiftDown(size_t index);
+    
+    void SwapItems(size_t left_index, size_t right_index);
+    
+private:
+    size_t capacity_ = 0;
+    
+    // min-heap by count
+    std::vector<Item> items_;
+    
+    // looked up by string_view, so counting a known key copies nothing
+    std::map<std::string, size_t, std::less<>> key_to_index_;
+};
@@ -1,18 +1,106 @@
-#include <sstream>
-
 #include "string_processing.hpp"
 
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace string_processing {
 
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-    std::istringstream text_stream(text);
+namespace {
+
+// The same characters std::isspace accepts in the "C" locale
+bool IsSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+#if defined(__AVX2__)
+
+constexpr size_t kBlockSize = 32;
+
+// Bit i is set when text[i] is a space
+uint32_t GetSpaceMask(const char* text) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text));
     
-    std::vector<std::string> words;
+    const __m256i is_blank = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
     
-    std::string word;
-    while (text_stream >> word) {
-        words.push_back(word);
+    // '\t'..'\r' are the only characters for which c - '\t' is at most 4 as an unsigned byte
+    const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+    const __m256i is_control_space = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(is_blank, is_control_space)));
+}
+
+#elif defined(__SSE2__)
+
+constexpr size_t kBlockSize = 16;
+
+// Bit i is set when text[i] is a space
+uint32_t GetSpaceMask(const char* text) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+    
+    const __m128i is_blank = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    
+    // '\t'..'\r' are the only characters for which c - '\t' is at most 4 as an unsigned byte
+    const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    const __m128i is_control_space = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(is_blank, is_control_space)));
+}
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+constexpr uint32_t kFullBlockMask = static_cast<uint32_t>((uint64_t{1} << kBlockSize) - 1);
+
+#endif
+
+} // namespace
+
+size_t FindWordBegin(std::string_view text, size_t position) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; position + kBlockSize <= text.size(); position += kBlockSize) {
+        const uint32_t non_space_mask = ~GetSpaceMask(text.data() + position) & kFullBlockMask;
+        
+        if (non_space_mask != 0) {
+            return position + static_cast<size_t>(__builtin_ctz(non_space_mask));
+        }
+    }
+#endif
+    
+    while (position < text.size() && IsSpace(text[position])) {
+        ++position;
+    }
+    
+    return position;
+}
+
+size_t FindWordEnd(std::string_view text, size_t position) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; position + kBlockSize <= text.size(); position += kBlockSize) {
+        const uint32_t space_mask = GetSpaceMask(text.data() + position);
+        
+        if (space_mask != 0) {
+            return position + static_cast<size_t>(__builtin_ctz(space_mask));
+        }
     }
+#endif
+    
+    while (position < text.size() && !IsSpace(text[position])) {
+        ++position;
+    }
+    
+    return position;
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    
+    ForEachWord(text, [&words](std::string_view word) {
+        words.push_back(word);
+    });
     
     return words;
 }
@@ -1,12 +1,35 @@
 #pragma once
 
 #include <vector>
-#include <string>
+#include <string_view>
 
 namespace string_processing {
 
-std::vector<std::string> SplitIntoWords(const std::string& text);
+// Returns the position of the first non-space character at or after position, or text.size()
+size_t FindWordBegin(std::string_view text, size_t position);
 
+// Returns the position of the first space character at or after position, or text.size()
+size_t FindWordEnd(std::string_view text, size_t position);
+
+// Calls function with a view of every word of text, without collecting them
+template <typename Function>
+void ForEachWord(std::string_view text, Function function);
+
+// Words are views into text, so text has to outlive them
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+template <typename Function>
+void ForEachWord(std::string_view text, Function function) {
+    size_t word_begin = FindWordBegin(text, 0);
+    
+    while (word_begin < text.size()) {
+        const size_t word_end = FindWordEnd(text, word_begin);
+        
+        function(text.substr(word_begin, word_end - word_begin));
+        
+        word_begin = FindWordBegin(text, word_end);
+    }
 }
 
+}
 
@@ -1,12 +1,34 @@
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <execution>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <memory>
 
 #include "test_search_server.hpp"
 #include "testing_framework.h"
 #include "search_server.hpp"
+#include "posting_list.hpp"
+#include "result_cache.hpp"
 #include "string_processing.hpp"
 #include "remove_duplicates.hpp"
+#include "near_duplicates.hpp"
+#include "write_ahead_log.hpp"
+#include "process_queries.hpp"
+#include "request_queue.hpp"
+#include "concurrent_request_queue.hpp"
+#include "space_saving_counter.hpp"
+#include "query_analytics.hpp"
+#include "sharded_search_server.hpp"
+#include "versioned_search_server.hpp"
+#include "concurrent_search_server.hpp"
+
+using namespace std::string_view_literals;
 
 void TestIteratingOverSearchServer() {
     SearchServer search_server;
@@ -41,7 +63,7 @@ void TestGetWordFrequencies() {
         
         const auto word_frequencies_of_not_existing_document = search_server.GetWordFrequencies(42);
         
-        std::map<std::string, double> empty_map;
+        std::map<std::string_view, double> empty_map;
         
         assert(empty_map == word_frequencies_of_not_existing_document);
     }
@@ -64,6 +86,49 @@ void TestDeletingDocument() {
     assert(results.empty());
 }
 
+void TestDeletingDocumentKeepsOthersIntact() {
+    SearchServer search_server;
+    
+    search_server.AddDocument(5, "white cat"s, DocumentStatus::kActual, {1});
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::kBanned, {2});
+    search_server.AddDocument(9, "grey cat"s, DocumentStatus::kActual, {3});
+    
+    search_server.RemoveDocument(5);
+    search_server.RemoveDocument(42);
+    
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2);
+    ASSERT_EQUAL(std::vector<int>(search_server.begin(), search_server.end()), (std::vector<int>{2, 9}));
+    
+    const auto found_docs = search_server.FindTopDocuments("grey cat"s);
+    
+    ASSERT_EQUAL(found_docs.size(), 1u);
+    ASSERT_EQUAL(found_docs[0].id, 9);
+    ASSERT_EQUAL(found_docs[0].rating, 3);
+    
+    ASSERT_EQUAL(std::get<1>(search_server.MatchDocument("cat"s, 2)), DocumentStatus::kBanned);
+    ASSERT_EQUAL(search_server.GetWordFrequencies(9).count("grey"s), 1u);
+}
+
+void TestDeletingDocumentsInBatchAndInParallel() {
+    SearchServer search_server;
+    
+    for (int document_id = 0; document_id < 10; ++document_id) {
+        search_server.AddDocument(document_id, "cat number"s + std::to_string(document_id) + (document_id % 2 ? " odd"s : " even"s),
+                                  DocumentStatus::kActual, {1});
+    }
+    
+    search_server.RemoveDocument(std::execution::par, 3);
+    search_server.RemoveDocuments({8, 0, 42, 5, 8});
+    
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 6);
+    ASSERT_EQUAL(std::vector<int>(search_server.begin(), search_server.end()), (std::vector<int>{1, 2, 4, 6, 7, 9}));
+    
+    ASSERT(search_server.FindTopDocuments("number3 number5 number8 number0"s).empty());
+    ASSERT_EQUAL(search_server.FindTopDocuments("odd"s, DocumentStatus::kActual, 10).size(), 3u);
+    ASSERT_EQUAL(search_server.FindTopDocuments("even"s, DocumentStatus::kActual, 10).size(), 3u);
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s, DocumentStatus::kActual, 10).size(), 6u);
+}
+
 void TestRemoveDuplicates() {
     SearchServer search_server;
     
@@ -77,6 +142,294 @@ void TestRemoveDuplicates() {
     assert(search_server.GetDocumentCount() == 3);
 }
 
+void TestRemoveDuplicatesReturnsIds() {
+    SearchServer search_server;
+    
+    search_server_helpers::AddDocument(search_server, 0, "funny bunny"s, DocumentStatus::kActual, {1, 2, 3});
+    search_server_helpers::AddDocument(search_server, 1, "funny doggy"s, DocumentStatus::kActual, {1, 2, 3});
+    search_server_helpers::AddDocument(search_server, 2, "happy cat"s, DocumentStatus::kActual, {1, 2, 3});
+    search_server_helpers::AddDocument(search_server, 3, "cat cat happy"s, DocumentStatus::kActual, {1, 2, 3});
+    search_server_helpers::AddDocument(search_server, 4, "doggy funny"s, DocumentStatus::kActual, {1, 2, 3});
+    search_server_helpers::AddDocument(search_server, 5, "funny"s, DocumentStatus::kActual, {1, 2, 3});
+    
+    ASSERT_EQUAL(remove_duplicates::FindDuplicates(search_server), (std::vector<int>{3, 4}));
+    
+    ASSERT_EQUAL(remove_duplicates::RemoveDuplicates(search_server), (std::vector<int>{3, 4}));
+    
+    assert(search_server.GetDocumentCount() == 4);
+}
+
+void TestAddDocumentsBatch() {
+    const std::vector<std::string> contents = {
+        "funny pet and nasty rat"s, "funny pet with curly hair"s, "nasty rat with curly hair"s, "big dog and cat"s,
+    };
+    
+    SearchServer one_by_one_server("and with"s);
+    SearchServer batch_server("and with"s);
+    
+    std::vector<RawDocument> batch;
+    
+    for (size_t i = 0; i < contents.size(); ++i) {
+        // ids are deliberately not ordered
+        const int document_id = static_cast<int>((i * 3) % contents.size());
+        
+        one_by_one_server.AddDocument(document_id, contents[i], DocumentStatus::kActual, {static_cast<int>(i)});
+        batch.push_back({document_id, contents[i], DocumentStatus::kActual, {static_cast<int>(i)}});
+    }
+    
+    batch_server.AddDocuments(std::execution::par, batch);
+    
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), one_by_one_server.GetDocumentCount());
+    ASSERT_EQUAL(std::vector<int>(batch_server.begin(), batch_server.end()),
+                 std::vector<int>(one_by_one_server.begin(), one_by_one_server.end()));
+    
+    for (const int document_id : one_by_one_server) {
+        ASSERT_EQUAL(batch_server.GetWordFrequencies(document_id), one_by_one_server.GetWordFrequencies(document_id));
+    }
+    
+    const auto batch_docs = batch_server.FindTopDocuments("curly nasty rat"s);
+    const auto one_by_one_docs = one_by_one_server.FindTopDocuments("curly nasty rat"s);
+    
+    ASSERT_EQUAL(batch_docs.size(), one_by_one_docs.size());
+    
+    for (size_t i = 0; i < batch_docs.size(); ++i) {
+        ASSERT_EQUAL(batch_docs[i].id, one_by_one_docs[i].id);
+    }
+    
+    // nothing is added from a batch with an invalid document
+    try {
+        batch_server.AddDocuments({{10, "big cat"sv, DocumentStatus::kActual, {1}},
+                                   {11, "big ca\x12t"sv, DocumentStatus::kActual, {1}}});
+        ASSERT_HINT(false, "batch with invalid document is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+    
+    try {
+        batch_server.AddDocuments({{12, "big cat"sv, DocumentStatus::kActual, {1}},
+                                   {12, "big dog"sv, DocumentStatus::kActual, {1}}});
+        ASSERT_HINT(false, "batch with repeating ids is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+    
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), static_cast<int>(contents.size()));
+    ASSERT(batch_server.FindTopDocuments("big"s).size() == 1);
+}
+
+void TestNearDuplicates() {
+    SearchServer search_server;
+    
+    std::string common_words;
+    for (int i = 0; i < 40; ++i) {
+        common_words += " word"s + std::to_string(i);
+    }
+    
+    search_server.AddDocument(1, "first"s + common_words, DocumentStatus::kActual, {1});
+    search_server.AddDocument(2, "second"s + common_words, DocumentStatus::kActual, {1});
+    search_server.AddDocument(3, "completely different document about cats and dogs"s, DocumentStatus::kActual, {1});
+    search_server.AddDocument(4, "third"s + common_words, DocumentStatus::kActual, {1});
+    
+    ASSERT_EQUAL(remove_duplicates::FindNearDuplicates(search_server, 0.8), (std::vector<int>{2, 4}));
+    ASSERT(remove_duplicates::FindNearDuplicates(search_server, 0.99).empty());
+    
+    remove_duplicates::NearDuplicateDetector detector(0.8);
+    
+    for (const int document_id : search_server) {
+        detector.AddDocument(document_id, search_server.GetWordFrequencies(document_id));
+    }
+    
+    ASSERT_EQUAL(detector.FindNearDuplicates(1), (std::vector<int>{2, 4}));
+    ASSERT(detector.FindNearDuplicates(3).empty());
+    
+    detector.RemoveDocument(2);
+    
+    ASSERT_EQUAL(detector.FindNearDuplicates(1), (std::vector<int>{4}));
+    ASSERT_EQUAL(detector.GetDocumentCount(), 3u);
+    
+    // an attached detector takes the documents of the server and follows its changes, copies leave it alone
+    const auto attached_detector = std::make_shared<remove_duplicates::NearDuplicateDetector>(0.8);
+    search_server.AttachNearDuplicateDetector(attached_detector);
+    
+    ASSERT_EQUAL(attached_detector->FindNearDuplicates(1), (std::vector<int>{2, 4}));
+    
+    search_server.RemoveDocument(2);
+    search_server.RemoveDocuments({4});
+    search_server.AddDocument(5, "fifth"s + common_words, DocumentStatus::kActual, {1});
+    search_server.AddDocuments({{6, "sixth"s + common_words, DocumentStatus::kActual, {1}}});
+    
+    ASSERT_EQUAL(attached_detector->FindNearDuplicates(1), (std::vector<int>{5, 6}));
+    ASSERT_EQUAL(attached_detector->GetDocumentCount(), 4u);
+    
+    SearchServer server_copy = search_server;
+    server_copy.RemoveDocument(5);
+    
+    ASSERT_EQUAL(attached_detector->FindNearDuplicates(1), (std::vector<int>{5, 6}));
+    
+    // 30 shared words out of 50, Jaccard index 0.6
+    std::string shared_words;
+    for (int i = 0; i < 30; ++i) {
+        shared_words += " shared"s + std::to_string(i);
+    }
+    
+    std::string left_words = shared_words;
+    std::string right_words = shared_words;
+    for (int i = 0; i < 10; ++i) {
+        left_words += " left"s + std::to_string(i);
+        right_words += " right"s + std::to_string(i);
+    }
+    
+    SearchServer loose_server;
+    loose_server.AddDocument(1, left_words, DocumentStatus::kActual, {1});
+    loose_server.AddDocument(2, right_words, DocumentStatus::kActual, {1});
+    
+    ASSERT_EQUAL(remove_duplicates::FindNearDuplicates(loose_server, 0.5), (std::vector<int>{2}));
+    ASSERT(remove_duplicates::FindNearDuplicates(loose_server, 0.8).empty());
+    
+    const remove_duplicates::NearDuplicateDetector loose_detector(0.5);
+    ASSERT(std::pow(1.0 / loose_detector.GetBandCount(), 1.0 / loose_detector.GetRowsPerBand()) <= 0.5);
+}
+
+void TestIndexSnapshot() {
+    const std::string path = "test_index_snapshot.bin"s;
+    
+    SearchServer search_server("and with"s);
+    
+    search_server.AddDocument(3, "funny pet and nasty rat"s, DocumentStatus::kActual, {7, 2, 7});
+    search_server.AddDocument(1, "funny pet with curly hair"s, DocumentStatus::kBanned, {1, 2});
+    search_server.AddDocument(2, "nasty rat with curly hair"s, DocumentStatus::kActual, {-5});
+    search_server.AddDocument(4, "big dog"s, DocumentStatus::kActual, {3});
+    search_server.RemoveDocument(4);
+    
+    search_server.SaveSnapshot(path);
+    
+    SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), search_server.GetDocumentCount());
+    ASSERT_EQUAL(std::vector<int>(loaded_server.begin(), loaded_server.end()), (std::vector<int>{1, 2, 3}));
+    
+    for (const int document_id : search_server) {
+        ASSERT_EQUAL(loaded_server.GetWordFrequencies(document_id), search_server.GetWordFrequencies(document_id));
+    }
+    
+    for (const std::string& query : {"nasty curly and"s, "funny -rat"s, "dog"s}) {
+        for (const DocumentStatus status : {DocumentStatus::kActual, DocumentStatus::kBanned}) {
+            const auto expected_docs = search_server.FindTopDocuments(query, status);
+            const auto found_docs = loaded_server.FindTopDocuments(query, status);
+            
+            ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+            
+            for (size_t i = 0; i < found_docs.size(); ++i) {
+                ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+                ASSERT_EQUAL(found_docs[i].rating, expected_docs[i].rating);
+                ASSERT_EQUAL(found_docs[i].relevance, expected_docs[i].relevance);
+            }
+        }
+    }
+    
+    // mapped postings are copied once changed
+    loaded_server.AddDocument(5, "nasty cat"s, DocumentStatus::kActual, {1});
+    loaded_server.RemoveDocument(3);
+    
+    ASSERT_EQUAL(loaded_server.FindTopDocuments("nasty"s).size(), 2u);
+    
+    std::remove(path.c_str());
+    
+    try {
+        SearchServer::LoadSnapshot(path);
+        ASSERT_HINT(false, "loading missing snapshot is not handled"s);
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void TestWriteAheadLogRecovery() {
+    const std::string snapshot_path = "test_wal_snapshot.bin"s;
+    const std::string log_path = "test_wal.log"s;
+    
+    std::remove(snapshot_path.c_str());
+    std::remove(log_path.c_str());
+    
+    {
+        SearchServer search_server("and with"s);
+        search_server.AttachWriteAheadLog(std::make_shared<WriteAheadLog>(log_path));
+        
+        search_server.AddDocument(1, "funny pet with curly hair"s, DocumentStatus::kActual, {1, 2});
+        search_server.AddDocument(2, "nasty rat with curly hair"s, DocumentStatus::kBanned, {-5});
+        search_server.Checkpoint(snapshot_path);
+        
+        search_server.AddDocuments({{3, "big dog"sv, DocumentStatus::kActual, {3}},
+                                    {4, "nasty dog"sv, DocumentStatus::kActual, {4}}});
+        search_server.RemoveDocuments({1, 4});
+        
+        // a rejected batch is not logged
+        try {
+            search_server.AddDocuments({{6, "big cat"sv, DocumentStatus::kActual, {6}},
+                                        {6, "big rat"sv, DocumentStatus::kActual, {6}}});
+            ASSERT_HINT(false, "batch with repeating ids is not handled"s);
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    
+    // a record torn by a crash is cut off
+    {
+        std::ofstream log_file(log_path, std::ios::binary | std::ios::app);
+        log_file << "\x40\x00\x00\x00torn"s;
+    }
+    
+    {
+        const auto write_ahead_log = std::make_shared<WriteAheadLog>(log_path);
+        
+        // the compaction has dropped the changes contained in the snapshot
+        int replayed_count = 0;
+        write_ahead_log->Replay(0, [&replayed_count](const LogRecord&) {
+            ++replayed_count;
+        });
+        ASSERT_EQUAL(replayed_count, 4);
+        
+        SearchServer recovered_server = SearchServer::LoadSnapshot(snapshot_path);
+        recovered_server.AttachWriteAheadLog(write_ahead_log);
+        
+        ASSERT_EQUAL(std::vector<int>(recovered_server.begin(), recovered_server.end()), (std::vector<int>{2, 3}));
+        ASSERT_EQUAL(recovered_server.FindTopDocuments("dog with"s).size(), 1u);
+        ASSERT_EQUAL(recovered_server.FindTopDocuments("rat"s, DocumentStatus::kBanned).size(), 1u);
+        
+        recovered_server.AddDocument(5, "curly cat"s, DocumentStatus::kActual, {5});
+    }
+    
+    // changes made after a recovery are logged as well
+    {
+        SearchServer recovered_server = SearchServer::LoadSnapshot(snapshot_path);
+        recovered_server.AttachWriteAheadLog(std::make_shared<WriteAheadLog>(log_path));
+        
+        ASSERT_EQUAL(std::vector<int>(recovered_server.begin(), recovered_server.end()), (std::vector<int>{2, 3, 5}));
+    }
+    
+    // a failed compaction is thrown to the next caller and leaves every record in the log
+    {
+        const std::string compacted_path = log_path + ".compact"s;
+        std::filesystem::create_directory(compacted_path);
+        
+        WriteAheadLog write_ahead_log(log_path);
+        write_ahead_log.CompactAsync(write_ahead_log.GetLastSequenceNumber());
+        
+        try {
+            write_ahead_log.WaitForCompaction();
+            ASSERT_HINT(false, "failed compaction is not reported"s);
+        } catch (const std::runtime_error&) {
+        }
+        
+        write_ahead_log.WaitForCompaction();
+        std::filesystem::remove(compacted_path);
+        
+        int replayed_count = 0;
+        write_ahead_log.Replay(0, [&replayed_count](const LogRecord&) {
+            ++replayed_count;
+        });
+        ASSERT_EQUAL(replayed_count, 5);
+    }
+    
+    std::remove(snapshot_path.c_str());
+    std::remove(log_path.c_str());
+}
+
 void TestStopWordsExclusion() {
     const std::vector<int> ratings = {1, 2, 3};
     
@@ -164,7 +517,7 @@ void TestMatchDocumentResults() {
         
         const auto [words, status] = server.MatchDocument("fat cat out of city"s, 42);
         
-        std::vector<std::string> desired_matched_words{"cat"s, "city"s};
+        std::vector<std::string_view> desired_matched_words{"cat"sv, "city"sv};
         
         ASSERT_EQUAL(words, desired_matched_words);
         ASSERT_EQUAL(status, DocumentStatus::kActual);
@@ -179,13 +532,90 @@ void TestMatchDocumentResults() {
         
         const auto [words, status] = server.MatchDocument("fat cat out of city and a cute dog"s, 43);
         
-        std::vector<std::string> desired_matched_words{"dog"s};
+        std::vector<std::string_view> desired_matched_words{"dog"sv};
         
         ASSERT_EQUAL(words, desired_matched_words);
         ASSERT_EQUAL(status, DocumentStatus::kBanned);
     }
 }
 
+void TestParallelMatchDocument() {
+    SearchServer server("and with"s);
+    
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::kActual, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::kBanned, {1, 2});
+    
+    const std::string query = "curly and funny -not rat funny curly"s;
+    
+    {
+        const auto [words, status] = server.MatchDocument(std::execution::par, query, 1);
+        
+        ASSERT_EQUAL(words, (std::vector<std::string_view>{"funny"sv, "rat"sv}));
+        ASSERT_EQUAL(status, DocumentStatus::kActual);
+    }
+    
+    {
+        const auto [words, status] = server.MatchDocument(std::execution::par, query, 2);
+        
+        ASSERT_EQUAL(words, (std::vector<std::string_view>{"curly"sv, "funny"sv}));
+        ASSERT_EQUAL(status, DocumentStatus::kBanned);
+    }
+    
+    {
+        const auto [words, status] = server.MatchDocument(std::execution::par, "funny -rat"s, 1);
+        
+        ASSERT(words.empty());
+    }
+    
+    ASSERT(std::get<0>(server.MatchDocument(std::execution::seq, query, 2))
+           == std::get<0>(server.MatchDocument(std::execution::par, query, 2)));
+}
+
+void TestProcessQueries() {
+    SearchServer server("and with"s);
+    
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::kActual, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::kActual, {1, 2});
+    server.AddDocument(3, "big dog nasty hair"s, DocumentStatus::kActual, {1, 2});
+    
+    const std::vector<std::string> queries = {"nasty rat -not"s, "unknown words"s, "curly hair"s};
+    
+    const auto documents = process_queries::ProcessQueries(server, queries);
+    
+    ASSERT_EQUAL(documents.size(), 3u);
+    
+    std::vector<int> expected_ids;
+    
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto query_documents = server.FindTopDocuments(queries[i]);
+        
+        ASSERT_EQUAL(documents[i].size(), query_documents.size());
+        
+        for (const Document& document : query_documents) {
+            expected_ids.push_back(document.id);
+        }
+    }
+    
+    const auto joined_documents = process_queries::ProcessQueriesJoined(server, queries);
+    
+    std::vector<int> joined_ids;
+    
+    for (const Document& document : joined_documents) {
+        joined_ids.push_back(document.id);
+    }
+    
+    ASSERT_EQUAL(joined_documents.size(), expected_ids.size());
+    ASSERT_EQUAL(joined_ids, expected_ids);
+    
+    try {
+        process_queries::ProcessQueries(server, {"cat"s, "--cat"s});
+    } catch (const std::invalid_argument&) {
+        return;
+    }
+    
+    ASSERT_HINT(false, "invalid query in a batch is not reported"s);
+}
+
 void TestFindTopDocumentsResultsSorting() {
     constexpr double kAccuracy = 1e-6;
     
@@ -236,6 +666,30 @@ void TestFindTopDocumentsResultsSorting() {
     }
 }
 
+void TestMaxResultDocumentCount() {
+    SearchServer server;
+    
+    // ratings differ, so equally relevant documents still have a strict order
+    for (int document_id = 0; document_id < 20; ++document_id) {
+        server.AddDocument(document_id, "cat city "s + std::string(static_cast<size_t>(document_id % 7 + 1), 'a'),
+                           DocumentStatus::kActual, {document_id});
+    }
+    
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 5u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::kActual, 12).size(), 12u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::kActual, 50).size(), 20u);
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::kActual, 0).empty());
+    
+    const auto top_documents = server.FindTopDocuments("cat aaa"s, DocumentStatus::kActual, 3);
+    const auto all_documents = server.FindTopDocuments("cat aaa"s, DocumentStatus::kActual, 20);
+    
+    ASSERT_EQUAL(top_documents.size(), 3u);
+    
+    for (size_t i = 0; i < top_documents.size(); ++i) {
+        ASSERT_EQUAL(top_documents[i].id, all_documents[i].id);
+    }
+}
+
 void TestRatingsCalculation() {
     const std::string content = "cat city"s;
     
@@ -368,9 +822,958 @@ void TestRelevanceCalculation() {
     }
 }
 
+void TestCachedInverseDocumentFrequencyFollowsIndexChanges() {
+    SearchServer server;
+    
+    server.AddDocument(0, "cat city"s, DocumentStatus::kActual, {1});
+    server.AddDocument(1, "dog city"s, DocumentStatus::kActual, {1});
+    
+    const auto find_relevance = [&server](const std::string& query) {
+        return server.FindTopDocuments(query).at(0).relevance;
+    };
+    
+    ASSERT(std::abs(find_relevance("cat"s) - std::log(2.0) * 0.5) < 1e-6);
+    ASSERT(std::abs(find_relevance("cat"s) - std::log(2.0) * 0.5) < 1e-6);
+    
+    server.AddDocument(2, "potato"s, DocumentStatus::kActual, {1});
+    ASSERT(std::abs(find_relevance("cat"s) - std::log(3.0) * 0.5) < 1e-6);
+    ASSERT(std::abs(find_relevance("city"s) - std::log(1.5) * 0.5) < 1e-6);
+    
+    const SearchServer server_copy = server;
+    
+    server.RemoveDocument(2);
+    ASSERT(std::abs(find_relevance("cat"s) - std::log(2.0) * 0.5) < 1e-6);
+    ASSERT(std::abs(find_relevance("city"s)) < 1e-6);
+    
+    ASSERT(std::abs(server_copy.FindTopDocuments(std::execution::par, "cat"s).at(0).relevance - std::log(3.0) * 0.5) < 1e-6);
+}
+
+void TestResultCache() {
+    SearchServer server("and with"s);
+    server.SetResultCacheCapacity(2);
+    
+    server.AddDocument(1, "white cat and yellow hat"s, DocumentStatus::kActual, {1, 2});
+    server.AddDocument(2, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    
+    const auto first_docs = server.FindTopDocuments("cat curly"s);
+    
+    // words of a query are normalized before they make a key
+    const auto second_docs = server.FindTopDocuments(std::execution::par, "curly cat cat and"s);
+    
+    ASSERT_EQUAL(first_docs.size(), second_docs.size());
+    ASSERT_EQUAL(second_docs[0].id, 2);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().hit_count, 1u);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().miss_count, 1u);
+    
+    // predicates are not cached
+    server.FindTopDocuments("cat"s, [](int, DocumentStatus, int) { return true; });
+    ASSERT_EQUAL(server.GetResultCacheStatistics().miss_count, 1u);
+    
+    server.FindTopDocuments("cat curly"s, DocumentStatus::kBanned);
+    server.FindTopDocuments("cat curly"s, DocumentStatus::kActual, 1);
+    
+    // the least recently used result is evicted
+    server.FindTopDocuments("cat curly"s);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().miss_count, 4u);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().entry_count, 2u);
+    
+    server.AddDocument(3, "black cat"s, DocumentStatus::kActual, {9});
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::kActual, 1)[0].id, 3);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().miss_count, 5u);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().entry_count, 1u);
+    
+    const SearchServer server_copy = server;
+    ASSERT_EQUAL(server_copy.GetResultCacheStatistics().entry_count, 0u);
+    
+    server_copy.FindTopDocuments("cat"s);
+    server_copy.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(server_copy.GetResultCacheStatistics().hit_count, 1u);
+    
+    server.SetResultCacheCapacity(0);
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(server.GetResultCacheStatistics().miss_count, 0u);
+    
+    // a query that started before a change neither drops nor replaces newer results
+    QueryResultCache cache(4);
+    std::vector<Document> result;
+    
+    cache.Insert("cat"s, 2, {Document(1, 0.5, 1)});
+    ASSERT(!cache.Find("cat"s, 1, result));
+    
+    cache.Insert("dog"s, 1, {Document(2, 0.5, 1)});
+    ASSERT(!cache.Find("dog"s, 2, result));
+    
+    ASSERT(cache.Find("cat"s, 2, result));
+    ASSERT_EQUAL(result[0].id, 1);
+    ASSERT_EQUAL(cache.GetStatistics().entry_count, 1u);
+    
+    ASSERT(!cache.Find("cat"s, 3, result));
+    ASSERT_EQUAL(cache.GetStatistics().entry_count, 0u);
+}
+
+void TestRequestQueueTimeWindow() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    
+    RequestQueue::Clock::time_point now;
+    RequestQueue request_queue(server, std::chrono::minutes(1), 3, [&now] {
+        return now;
+    });
+    
+    request_queue.AddFindRequest("dog"s);
+    now += std::chrono::seconds(20);
+    request_queue.AddFindRequest("cat"s);
+    request_queue.AddFindRequest("rat"s, DocumentStatus::kBanned);
+    
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+    
+    // the first request falls out of the window
+    now += std::chrono::seconds(40);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1);
+    
+    request_queue.AddFindRequest("tail"s, [](int, DocumentStatus, int) { return true; });
+    request_queue.AddFindRequest("hat"s);
+    request_queue.AddFindRequest("hair"s);
+    
+    // no more than three latest requests are kept
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+    
+    now += std::chrono::minutes(5);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 0);
+    
+    RequestWindow window(std::chrono::seconds(1), 2);
+    window.Record(now, 0);
+    ASSERT_EQUAL(window.GetRequestCount(now), 1u);
+    ASSERT_EQUAL(window.GetRequestCount(now + std::chrono::seconds(1)), 0u);
+}
+
+void TestQueryAnalytics() {
+    SpaceSavingCounter counter(2);
+    
+    for (const std::string_view key : {"a"sv, "a"sv, "b"sv, "a"sv, "c"sv}) {
+        counter.Add(key);
+    }
+    
+    // "c" replaces "b" and inherits its count
+    const auto items = counter.GetItems();
+    ASSERT_EQUAL(items.size(), 2u);
+    ASSERT_EQUAL(items[0].key, "a"s);
+    ASSERT_EQUAL(items[0].count, 3u);
+    ASSERT_EQUAL(items[1].key, "c"s);
+    ASSERT_EQUAL(items[1].count, 2u);
+    ASSERT_EQUAL(items[1].error, 1u);
+    ASSERT_EQUAL(counter.GetMinCount(), 2u);
+    
+    // long keys are cut, so the ones sharing a prefix are counted together
+    SpaceSavingCounter long_key_counter(1);
+    long_key_counter.Add(std::string(SpaceSavingCounter::kMaxKeyLength, 'x') + "a"s);
+    long_key_counter.Add(std::string(SpaceSavingCounter::kMaxKeyLength, 'x') + "b"s);
+    
+    const auto long_key_items = long_key_counter.GetItems();
+    ASSERT_EQUAL(long_key_items[0].key.size(), SpaceSavingCounter::kMaxKeyLength);
+    ASSERT_EQUAL(long_key_items[0].count, 2u);
+    ASSERT_EQUAL(long_key_items[0].error, 0u);
+    
+    // a pane which dropped a query counts it with its minimum, so merged counts are never too low
+    QueryAnalytics analytics(std::chrono::minutes(2), 2, 2);
+    QueryAnalytics::Clock::time_point analytics_now;
+    
+    for (const std::string_view query : {"a"sv, "a"sv, "a"sv, "b"sv, "b"sv, "c"sv}) {
+        analytics.Record(analytics_now, query, 1);
+    }
+    
+    analytics_now += std::chrono::minutes(1);
+    analytics.Record(analytics_now, "b"sv, 1);
+    
+    const auto merged_queries = analytics.GetTopQueries(analytics_now, 3);
+    ASSERT_EQUAL(merged_queries.size(), 3u);
+    ASSERT_EQUAL(merged_queries[0].query, "b"s);
+    ASSERT_EQUAL(merged_queries[0].count, 4u);
+    
+    // a request that arrives late for a pane already reused by a newer time is dropped,
+    // it neither resets the pane nor gets counted
+    analytics_now += std::chrono::minutes(2);
+    analytics.Record(analytics_now, "d"sv, 1);
+    analytics.Record(analytics_now - std::chrono::minutes(2), "e"sv, 1);
+    
+    const auto late_queries = analytics.GetTopQueries(analytics_now, 3);
+    ASSERT_EQUAL(late_queries.size(), 1u);
+    ASSERT_EQUAL(late_queries[0].query, "d"s);
+    ASSERT_EQUAL(late_queries[0].count, 1u);
+    
+    SearchServer server("and with"s);
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    server.AddDocument(2, "white cat"s, DocumentStatus::kActual, {1});
+    
+    RequestQueue::Clock::time_point now;
+    RequestQueue request_queue(server, std::chrono::hours(1), 100, [&now] {
+        return now;
+    });
+    
+    for (int i = 0; i < 10; ++i) {
+        request_queue.AddFindRequest(i % 2 == 0 ? "cat"sv : "dog"sv);
+        now += std::chrono::minutes(5);
+    }
+    
+    request_queue.AddFindRequest("curly"sv);
+    request_queue.AddFindRequest("rat"sv);
+    
+    const auto top_queries = request_queue.GetTopQueries(2);
+    ASSERT_EQUAL(top_queries.size(), 2u);
+    ASSERT_EQUAL(top_queries[0].query, "cat"s);
+    ASSERT_EQUAL(top_queries[0].count, 5u);
+    ASSERT_EQUAL(top_queries[1].query, "dog"s);
+    
+    const auto top_no_result_queries = request_queue.GetTopNoResultQueries(5);
+    ASSERT_EQUAL(top_no_result_queries.size(), 2u);
+    ASSERT_EQUAL(top_no_result_queries[0].query, "dog"s);
+    ASSERT_EQUAL(top_no_result_queries[1].query, "rat"s);
+    
+    const auto histogram = request_queue.GetResultCountHistogram();
+    ASSERT_EQUAL(histogram[0], 6u);
+    ASSERT_EQUAL(histogram[1], 1u);
+    ASSERT_EQUAL(histogram[2], 5u);
+    
+    // only the requests of the last hour are reported
+    now += std::chrono::minutes(40);
+    ASSERT_EQUAL(request_queue.GetResultCountHistogram()[2], 1u);
+    
+    now += std::chrono::hours(2);
+    ASSERT(request_queue.GetTopQueries(2).empty());
+}
+
+void TestConcurrentRequestQueue() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    
+    ConcurrentRequestQueue request_queue(server);
+    
+    constexpr int kThreadCount = 4;
+    constexpr int kRequestCount = 3000;
+    
+    std::vector<std::thread> threads;
+    
+    for (int thread_index = 0; thread_index < kThreadCount; ++thread_index) {
+        threads.emplace_back([&request_queue] {
+            for (int i = 0; i < kRequestCount; ++i) {
+                request_queue.AddFindRequest(i % 3 == 0 ? "dog"sv : "cat"sv);
+            }
+        });
+    }
+    
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    request_queue.Aggregate();
+    
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), kThreadCount * kRequestCount / 3);
+    
+    // capacity 3 is rounded up to 4
+    BoundedMpscQueue<int> queue(3);
+    ASSERT_EQUAL(queue.GetCapacity(), 4u);
+    
+    for (size_t i = 0; i < queue.GetCapacity(); ++i) {
+        ASSERT(queue.TryPush(i));
+    }
+    
+    ASSERT(!queue.TryPush(4));
+    
+    int value = -1;
+    ASSERT(queue.TryPop(value));
+    ASSERT_EQUAL(value, 0);
+    ASSERT(queue.TryPush(4));
+}
+
+void TestParallelFindTopDocuments() {
+    SearchServer server("and with"s);
+    
+    server.AddDocument(1, "white cat and yellow hat"s, DocumentStatus::kActual, {1, 2});
+    server.AddDocument(2, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    server.AddDocument(3, "nasty dog with big eyes"s, DocumentStatus::kActual, {1, 2, 8});
+    server.AddDocument(4, "nasty pigeon john"s, DocumentStatus::kBanned, {1, 3, 2});
+    server.AddDocument(5, "big cat nasty hair"s, DocumentStatus::kActual, {4, 5, 6});
+    
+    const std::string query = "curly nasty cat big -hair"s;
+    
+    const auto sequential_docs = server.FindTopDocuments(std::execution::seq, query);
+    const auto parallel_docs = server.FindTopDocuments(std::execution::par, query);
+    
+    ASSERT_EQUAL(sequential_docs.size(), parallel_docs.size());
+    
+    for (size_t i = 0; i < sequential_docs.size(); ++i) {
+        ASSERT_EQUAL(sequential_docs[i].id, parallel_docs[i].id);
+        ASSERT(std::abs(sequential_docs[i].relevance - parallel_docs[i].relevance) < 1e-6);
+    }
+    
+    const auto banned_docs = server.FindTopDocuments(std::execution::par, query, DocumentStatus::kBanned);
+    
+    ASSERT_EQUAL(banned_docs.size(), 1u);
+    ASSERT_EQUAL(banned_docs[0].id, 4);
+    
+    // lists of thousands of postings are split between several tasks, removed and compressed postings included
+    SearchServer large_server;
+    
+    for (int id = 0; id < 10000; ++id) {
+        const std::string text = "cat"s + (id % 3 == 0 ? " dog"s : ""s) + (id % 7 == 0 ? " hair"s : ""s)
+                                 + " w"s + std::to_string(id % 50);
+        large_server.AddDocument(id, text, DocumentStatus::kActual, {id});
+    }
+    
+    for (int id = 0; id < 10000; id += 11) {
+        large_server.RemoveDocument(id);
+    }
+    
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const std::string& large_query : {"cat dog w7"s, "dog w3 w4 -hair"s}) {
+            const auto expected_docs = large_server.FindTopDocuments(std::execution::seq, large_query, DocumentStatus::kActual, 100);
+            const auto found_docs = large_server.FindTopDocuments(std::execution::par, large_query, DocumentStatus::kActual, 100);
+            
+            ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+            
+            for (size_t i = 0; i < found_docs.size(); ++i) {
+                ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+                ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+            }
+        }
+        
+        large_server.CompressIndex();
+    }
+}
+
+void TestPrunedTopDocumentsMatchExhaustiveSearch() {
+    SearchServer server("and with"s);
+    
+    // a few frequent words and many rare ones, so that some words become non-essential,
+    // and a word of every document, which scores nothing but still makes documents match
+    std::mt19937 generator(42);
+    std::vector<std::string> texts;
+    
+    for (int id = 0; id < 2000; ++id) {
+        std::string text = "all "s;
+        const int word_count = 3 + static_cast<int>(generator() % 8);
+        
+        for (int i = 0; i < word_count; ++i) {
+            const unsigned word_number = generator() % 4 == 0 ? generator() % 5 : generator() % 300;
+            text += "w"s + std::to_string(word_number) + " "s;
+        }
+        
+        texts.push_back(text);
+        server.AddDocument(id, texts.back(), static_cast<DocumentStatus>(id % 3), {id});
+    }
+    
+    const auto check_equal = [](const std::vector<Document>& found_docs, const std::vector<Document>& expected_docs) {
+        ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+        
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+            ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+        }
+    };
+    
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+    
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const std::string& query : {"w0 w1 w17 w42"s, "w2 w250 w251 w252 -w3"s, "w4 w100"s, "w299 w298 w0 w1 w2"s,
+                                         "w0 w1 w7 -w2 -w3 -w4"s, "w5 w6 -w0 -w1 -w2 -w3 -w4"s,
+                                         "all w298 -w0"s, "w17 all w0"s, "all -w1 -w2"s}) {
+            for (const int max_result_document_count : {1, 5, 50}) {
+                check_equal(server.FindTopDocuments(std::execution::seq, query, DocumentStatus::kActual, max_result_document_count),
+                            server.FindTopDocuments(std::execution::par, query, DocumentStatus::kActual, max_result_document_count));
+                check_equal(server.FindTopDocuments(std::execution::seq, query, is_even, max_result_document_count),
+                            server.FindTopDocuments(std::execution::par, query, is_even, max_result_document_count));
+            }
+        }
+        
+        // the first pass bounds blocks of plain lists, the second one blocks of compressed lists
+        server.CompressIndex();
+    }
+}
+
+void TestShardedSearchServer() {
+    SearchServer server("and with"s);
+    ShardedSearchServer sharded_server("and with"s, 4);
+    
+    std::mt19937 generator(7);
+    
+    // unique ratings, so documents of equal relevance are ordered the same way in both servers
+    for (int id = 0; id < 500; ++id) {
+        std::string text;
+        const int word_count = 2 + static_cast<int>(generator() % 6);
+        
+        for (int i = 0; i < word_count; ++i) {
+            text += "w"s + std::to_string(generator() % 40) + " "s;
+        }
+        
+        server.AddDocument(id, text, static_cast<DocumentStatus>(id % 3), {id});
+        sharded_server.AddDocument(id, text, static_cast<DocumentStatus>(id % 3), {id});
+    }
+    
+    server.RemoveDocument(17);
+    sharded_server.RemoveDocument(17);
+    
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), server.GetDocumentCount());
+    
+    const auto check_equal = [](const std::vector<Document>& found_docs, const std::vector<Document>& expected_docs) {
+        ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+        
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+            ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+        }
+    };
+    
+    const auto is_odd = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 1;
+    };
+    
+    for (const std::string& query : {"w0 w1 w2"s, "w3 w4 -w5"s, "w39 w38 w37 w36"s, "unknown"s}) {
+        check_equal(sharded_server.FindTopDocuments(query), server.FindTopDocuments(query));
+        check_equal(sharded_server.FindTopDocuments(query, DocumentStatus::kBanned, 20),
+                    server.FindTopDocuments(query, DocumentStatus::kBanned, 20));
+        check_equal(sharded_server.FindTopDocuments(query, is_odd, 10), server.FindTopDocuments(query, is_odd, 10));
+    }
+    
+    try {
+        sharded_server.AddDocument(-1, "w0"s, DocumentStatus::kActual, {});
+        ASSERT_HINT(false, "negative id is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+    
+    try {
+        sharded_server.FindTopDocuments("w0 --w1"s);
+        ASSERT_HINT(false, "double minus in a query is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+}
+
+void TestVersionedSearchServer() {
+    VersionedSearchServer server(SearchServer("and with"s));
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::kActual, {7, 2, 7});
+    
+    // a pinned version does not see later changes
+    VersionedSearchServer::Version version = server.GetVersion();
+    
+    server.AddDocument(2, "white cat and yellow hat"s, DocumentStatus::kActual, {1, 2});
+    server.RemoveDocument(1);
+    
+    // the posting list of "cat" was shared with the pinned version until it changed
+    ASSERT_EQUAL(version->GetDocumentCount(), 1);
+    ASSERT_EQUAL(version->FindTopDocuments("cat"s).size(), 1u);
+    ASSERT_EQUAL(version->FindTopDocuments("cat"s).front().id, 1);
+    ASSERT_EQUAL(version->GetWordFrequencies(1).size(), 3u);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).front().id, 2);
+    ASSERT_EQUAL(server.GetRetiredVersionCount(), 1u);
+    
+    // a replaced version is freed by its last query, without waiting for the next write
+    version.reset();
+    ASSERT_EQUAL(server.GetRetiredVersionCount(), 0u);
+    
+    // a failed change is not published
+    try {
+        server.Update([](SearchServer& search_server) {
+            search_server.AddDocument(3, "big dog"s, DocumentStatus::kActual, {1});
+            search_server.AddDocument(-1, "big dog"s, DocumentStatus::kActual, {1});
+        });
+        ASSERT_HINT(false, "negative id is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+    
+    ASSERT(server.FindTopDocuments("dog"s).empty());
+    
+    // queries run while documents are added and always see a complete version
+    std::atomic_bool is_writing = true;
+    
+    std::thread writer([&server, &is_writing] {
+        for (int id = 10; id < 110; ++id) {
+            server.AddDocument(id, "dog number "s + std::to_string(id), DocumentStatus::kActual, {id});
+        }
+        
+        is_writing = false;
+    });
+    
+    std::vector<std::thread> readers;
+    
+    for (int reader_index = 0; reader_index < 3; ++reader_index) {
+        readers.emplace_back([&server, &is_writing] {
+            int last_document_count = 0;
+            
+            while (is_writing) {
+                const VersionedSearchServer::Version current_version = server.GetVersion();
+                const int document_count = current_version->GetDocumentCount();
+                
+                ASSERT(document_count >= last_document_count);
+                ASSERT_EQUAL(static_cast<int>(current_version->FindTopDocuments("dog"s, DocumentStatus::kActual, 1000).size()),
+                             document_count - 1);
+                
+                last_document_count = document_count;
+            }
+        });
+    }
+    
+    writer.join();
+    
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    
+    ASSERT_EQUAL(server.GetDocumentCount(), 101);
+    
+    // single changes of concurrent writers share versions, and a failed one fails alone
+    std::atomic_int failed_count = 0;
+    std::vector<std::thread> writers;
+    
+    for (int writer_index = 0; writer_index < 4; ++writer_index) {
+        writers.emplace_back([&server, &failed_count, writer_index] {
+            for (int i = 0; i < 25; ++i) {
+                const int id = 200 + writer_index * 25 + i;
+                
+                try {
+                    server.AddDocument(i == 0 ? -id : id, "bird number "s + std::to_string(id), DocumentStatus::kActual, {id});
+                } catch (const std::invalid_argument&) {
+                    ++failed_count;
+                }
+            }
+        });
+    }
+    
+    for (std::thread& concurrent_writer : writers) {
+        concurrent_writer.join();
+    }
+    
+    ASSERT_EQUAL(failed_count.load(), 4);
+    ASSERT_EQUAL(server.GetDocumentCount(), 197);
+    ASSERT_EQUAL(server.FindTopDocuments("bird"s, DocumentStatus::kActual, 1000).size(), 96u);
+    
+    // every version logs to the log of the wrapped server
+    const std::string log_path = "test_versioned_wal.log"s;
+    std::remove(log_path.c_str());
+    
+    {
+        SearchServer logged_server("and with"s);
+        logged_server.AttachWriteAheadLog(std::make_shared<WriteAheadLog>(log_path));
+        
+        VersionedSearchServer versioned_server(std::move(logged_server));
+        versioned_server.AddDocument(1, "curly cat"s, DocumentStatus::kActual, {1});
+        versioned_server.AddDocument(2, "nasty rat"s, DocumentStatus::kActual, {2});
+        versioned_server.RemoveDocument(1);
+        
+        // with a log as without one, a failed change is neither published nor logged
+        try {
+            versioned_server.Update([](SearchServer& search_server) {
+                search_server.AddDocument(3, "big dog"s, DocumentStatus::kActual, {1});
+                search_server.AddDocument(-1, "big dog"s, DocumentStatus::kActual, {1});
+            });
+            ASSERT_HINT(false, "negative id is not handled"s);
+        } catch (const std::invalid_argument&) {
+        }
+        
+        ASSERT(versioned_server.FindTopDocuments("dog"s).empty());
+        
+        try {
+            versioned_server.AddDocument(2, "big dog"s, DocumentStatus::kActual, {1});
+            ASSERT_HINT(false, "repeating id is not handled"s);
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    
+    {
+        SearchServer recovered_server("and with"s);
+        recovered_server.AttachWriteAheadLog(std::make_shared<WriteAheadLog>(log_path));
+        
+        ASSERT_EQUAL(std::vector<int>(recovered_server.begin(), recovered_server.end()), std::vector<int>{2});
+    }
+    
+    // a checkpoint of the wrapper saves the current version and compacts the shared log
+    const std::string snapshot_path = "test_versioned_snapshot.bin"s;
+    std::remove(snapshot_path.c_str());
+    
+    {
+        SearchServer logged_server("and with"s);
+        logged_server.AttachWriteAheadLog(std::make_shared<WriteAheadLog>(log_path));
+        
+        VersionedSearchServer versioned_server(std::move(logged_server));
+        versioned_server.AddDocument(3, "curly dog"s, DocumentStatus::kActual, {3});
+        versioned_server.Checkpoint(snapshot_path);
+        
+        versioned_server.AddDocument(4, "big dog"s, DocumentStatus::kActual, {4});
+        versioned_server.RemoveDocument(2);
+        
+        versioned_server.GetVersion()->GetWriteAheadLog()->WaitForCompaction();
+    }
+    
+    {
+        const auto write_ahead_log = std::make_shared<WriteAheadLog>(log_path);
+        
+        // only the changes made after the checkpoint are left in the log
+        int replayed_count = 0;
+        write_ahead_log->Replay(0, [&replayed_count](const LogRecord&) {
+            ++replayed_count;
+        });
+        ASSERT_EQUAL(replayed_count, 2);
+        
+        SearchServer recovered_server = SearchServer::LoadSnapshot(snapshot_path);
+        recovered_server.AttachWriteAheadLog(write_ahead_log);
+        
+        ASSERT_EQUAL(std::vector<int>(recovered_server.begin(), recovered_server.end()), (std::vector<int>{3, 4}));
+        ASSERT_EQUAL(recovered_server.FindTopDocuments("dog"s).size(), 2u);
+    }
+    
+    std::remove(snapshot_path.c_str());
+    std::remove(log_path.c_str());
+}
+
+void TestConcurrentSearchServer() {
+    SearchServer server("and with"s);
+    ConcurrentSearchServer concurrent_server("and with"s);
+    
+    std::mt19937 generator(11);
+    std::vector<std::string> texts;
+    
+    for (int id = 0; id < 300; ++id) {
+        std::string text;
+        const int word_count = 2 + static_cast<int>(generator() % 6);
+        
+        for (int i = 0; i < word_count; ++i) {
+            text += "w"s + std::to_string(generator() % 30) + " "s;
+        }
+        
+        texts.push_back(text);
+    }
+    
+    // documents are added by several threads at once
+    std::vector<std::thread> writers;
+    
+    for (int writer_index = 0; writer_index < 4; ++writer_index) {
+        writers.emplace_back([&concurrent_server, &texts, writer_index] {
+            for (int id = writer_index; id < static_cast<int>(texts.size()); id += 4) {
+                concurrent_server.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+            }
+        });
+    }
+    
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+        server.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+    }
+    
+    server.RemoveDocument(5);
+    concurrent_server.RemoveDocument(5);
+    
+    ASSERT_EQUAL(concurrent_server.GetDocumentCount(), server.GetDocumentCount());
+    
+    const auto check_equal = [](const std::vector<Document>& found_docs, const std::vector<Document>& expected_docs) {
+        ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+        
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+            ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+        }
+    };
+    
+    const auto is_odd = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 1;
+    };
+    
+    for (const std::string& query : {"w0 w1 w2"s, "w3 w4 -w5"s, "w29 w28 w27"s, "unknown"s}) {
+        check_equal(concurrent_server.FindTopDocuments(query), server.FindTopDocuments(query));
+        check_equal(concurrent_server.FindTopDocuments(query, DocumentStatus::kBanned, 20),
+                    server.FindTopDocuments(query, DocumentStatus::kBanned, 20));
+        check_equal(concurrent_server.FindTopDocuments(query, is_odd, 10), server.FindTopDocuments(query, is_odd, 10));
+    }
+    
+    try {
+        concurrent_server.AddDocument(7, "w0"s, DocumentStatus::kActual, {1});
+        ASSERT_HINT(false, "repeating id is not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+    
+    // a document is found as soon as it is added, while queries keep running;
+    // every document contains "fresh", so a count of documents lagging behind its postings must not make relevance negative
+    ConcurrentSearchServer live_server("and with"s, 4, 16);
+    std::atomic_bool is_writing = true;
+    
+    std::thread writer([&live_server, &is_writing] {
+        for (int id = 1000; id < 1200; ++id) {
+            live_server.AddDocument(id, "fresh news "s + std::to_string(id) + (id % 2 == 1 ? " odd"s : ""s),
+                                    DocumentStatus::kActual, {1});
+            
+            ASSERT(!live_server.FindTopDocuments(std::to_string(id)).empty());
+            
+            if (id % 2 == 0) {
+                live_server.RemoveDocument(id);
+            }
+        }
+        
+        is_writing = false;
+    });
+    
+    std::thread reader([&live_server, &is_writing] {
+        while (is_writing) {
+            const auto found_docs = live_server.FindTopDocuments("fresh"s, DocumentStatus::kActual, 1000);
+            
+            ASSERT(found_docs.size() <= 200u);
+            ASSERT(std::all_of(found_docs.begin(), found_docs.end(), [](const Document& document) {
+                return std::isfinite(document.relevance) && document.relevance >= 0.0;
+            }));
+        }
+    });
+    
+    writer.join();
+    reader.join();
+    
+    ASSERT_EQUAL(live_server.GetDocumentCount(), 100);
+    ASSERT_EQUAL(live_server.FindTopDocuments("fresh"s, DocumentStatus::kActual, 1000).size(), 100u);
+    
+    // nothing has changed since the previous query
+    const uint64_t hit_count = live_server.GetResultCacheStatistics().hit_count;
+    live_server.FindTopDocuments("fresh"s, DocumentStatus::kActual, 1000);
+    ASSERT_EQUAL(live_server.GetResultCacheStatistics().hit_count, hit_count + 1);
+    
+    // with no writer running, counts and postings come from one epoch: every document matches,
+    // so the result holds the whole index and the frequency of "odd" follows from it
+    for (int id = 2000; id < 2020; id += 2) {
+        live_server.AddDocument(id, "fresh news "s + std::to_string(id), DocumentStatus::kActual, {1});
+    }
+    
+    const auto odd_docs = live_server.FindTopDocuments("fresh odd"s, DocumentStatus::kActual, 1000);
+    const auto odd_count = std::count_if(odd_docs.begin(), odd_docs.end(), [](const Document& document) {
+        return document.id % 2 == 1;
+    });
+    
+    ASSERT_EQUAL(odd_docs.size(), 110u);
+    ASSERT_EQUAL(odd_count, 100);
+    
+    for (const Document& document : odd_docs) {
+        if (document.id % 2 == 1) {
+            ASSERT(std::abs(document.relevance - 0.25 * std::log(110.0 / 100.0)) < 1e-9);
+        }
+    }
+}
+
+void TestPostingList() {
+    PostingList posting_list;
+    
+    posting_list.Add(1, DocumentStatus::kActual, 0.5);
+    posting_list.Add(7, DocumentStatus::kActual, 0.25);
+    posting_list.Add(3, DocumentStatus::kActual, 1.0); // out of order id is inserted in place
+    
+    std::vector<int> document_ids;
+    posting_list.ForEach([&document_ids](const Posting& posting) {
+        document_ids.push_back(posting.document_id);
+    });
+    
+    ASSERT_EQUAL(document_ids, (std::vector<int>{1, 3, 7}));
+    
+    posting_list.Remove(3);
+    
+    ASSERT_EQUAL(posting_list.size(), 2u);
+    ASSERT(!posting_list.Contains(3));
+    ASSERT(posting_list.Contains(7));
+    
+    posting_list.Add(3, DocumentStatus::kActual, 0.75);
+    
+    ASSERT_EQUAL(posting_list.size(), 3u);
+    ASSERT(posting_list.Contains(3));
+    
+    posting_list.Remove(1);
+    posting_list.Remove(3);
+    posting_list.Remove(7);
+    
+    ASSERT(posting_list.empty());
+    
+    // an uncompressed list bounds term frequencies per block, so a rare high frequency stays in its block
+    PostingList blocked_list;
+    
+    for (int id = 0; id < 6 * static_cast<int>(PostingList::kBlockSize); id += 2) {
+        blocked_list.Add(id, DocumentStatus::kActual, id == 10 ? 1.0 : 0.125);
+    }
+    
+    blocked_list.Add(301, DocumentStatus::kActual, 0.5); // inserted, the blocks after it shift
+    
+    PostingList::Cursor cursor(blocked_list);
+    
+    ASSERT_EQUAL(cursor.GetMaxTermFrequency(10), 1.0);
+    ASSERT_EQUAL(cursor.GetMaxTermFrequency(301), 0.5);
+    ASSERT_EQUAL(cursor.GetMaxTermFrequency(700), 0.125);
+    ASSERT_EQUAL(cursor.GetMaxTermFrequency(1001), 0.0);
+}
+
+void TestCompressedPostingList() {
+    PostingList posting_list;
+    std::vector<Posting> expected_postings;
+    
+    // gaps of every byte length cross the block and group boundaries
+    int document_id = 0;
+    
+    for (int i = 0; i < 1000; ++i) {
+        const auto status = static_cast<DocumentStatus>(i % 4);
+        const double term_frequency = 1.0 / (i % 7 + 1);
+        
+        posting_list.Add(document_id, status, term_frequency);
+        expected_postings.push_back({document_id, status, term_frequency});
+        
+        document_id += 1 + (i % 3 == 0 ? 1 << (8 * (i % 4)) : i % 5);
+    }
+    
+    const size_t uncompressed_size = expected_postings.size() * sizeof(Posting);
+    
+    posting_list.Compress();
+    
+    ASSERT(posting_list.IsCompressed());
+    ASSERT_EQUAL(posting_list.size(), expected_postings.size());
+    ASSERT(CompressedPostings(expected_postings).GetByteSize() * 2 < uncompressed_size);
+    
+    size_t index = 0;
+    posting_list.ForEach([&](const Posting& posting) {
+        ASSERT_EQUAL(posting.document_id, expected_postings[index].document_id);
+        ASSERT_EQUAL(static_cast<int>(posting.status), static_cast<int>(expected_postings[index].status));
+        ASSERT(std::abs(posting.term_frequency - expected_postings[index].term_frequency) < 1e-7);
+        ++index;
+    });
+    ASSERT_EQUAL(index, expected_postings.size());
+    
+    ASSERT(posting_list.Contains(expected_postings[501].document_id));
+    ASSERT(!posting_list.Contains(expected_postings[501].document_id + 1));
+    ASSERT(!posting_list.Contains(document_id));
+    
+    // a copy of a cursor keeps its own decoded block
+    PostingList::Cursor cursor(posting_list);
+    cursor.Seek(expected_postings[300].document_id);
+    
+    const PostingList::Cursor cursor_copy = cursor;
+    cursor.Seek(expected_postings[900].document_id);
+    
+    ASSERT_EQUAL(cursor_copy.GetPosting().document_id, expected_postings[300].document_id);
+    ASSERT_EQUAL(cursor.GetPosting().document_id, expected_postings[900].document_id);
+    
+    // a change unpacks the list
+    posting_list.Remove(expected_postings[0].document_id);
+    
+    ASSERT(!posting_list.IsCompressed());
+    ASSERT_EQUAL(posting_list.size(), expected_postings.size() - 1);
+    ASSERT(!posting_list.Contains(expected_postings[0].document_id));
+    ASSERT(posting_list.Contains(expected_postings[999].document_id));
+    
+    SearchServer search_server("and with"s);
+    
+    for (int id = 0; id < 300; ++id) {
+        search_server.AddDocument(id, id % 2 == 0 ? "funny pet and nasty rat"s : "curly dog with curly hair"s,
+                                  static_cast<DocumentStatus>(id % 3), {id});
+    }
+    
+    const SearchServer uncompressed_server = search_server;
+    search_server.CompressIndex();
+    
+    for (const std::string& query : {"nasty curly"s, "curly -rat"s, "pet dog hair"s, "nasty dog -funny -pet -rat"s}) {
+        const auto expected_docs = uncompressed_server.FindTopDocuments(std::execution::par, query);
+        const auto found_docs = search_server.FindTopDocuments(std::execution::seq, query);
+        
+        ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+        
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+            ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < 1e-6);
+        }
+    }
+    
+    search_server.RemoveDocument(0);
+    ASSERT_EQUAL(std::get<0>(search_server.MatchDocument("curly"s, 1)).size(), 1u);
+    
+    // float term frequencies keep the order of near ties: relevances closer than kAccuracy
+    // are ordered by rating, farther ones by relevance, with or without compression
+    const auto make_text = [](const std::string& word, int filler_count) {
+        std::string text = word;
+        
+        for (int i = 0; i < filler_count; ++i) {
+            text += " w"s + std::to_string(i);
+        }
+        
+        return text;
+    };
+    
+    SearchServer near_tie_server;
+    near_tie_server.AddDocument(10, make_text("cat"s, 999), DocumentStatus::kActual, {1});
+    near_tie_server.AddDocument(11, make_text("cat"s, 1000), DocumentStatus::kActual, {9});
+    near_tie_server.AddDocument(20, make_text("rat"s, 99), DocumentStatus::kActual, {1});
+    near_tie_server.AddDocument(21, make_text("rat"s, 100), DocumentStatus::kActual, {9});
+    
+    const SearchServer uncompressed_near_tie_server = near_tie_server;
+    near_tie_server.CompressIndex();
+    const SearchServer& compressed_near_tie_server = near_tie_server;
+    
+    for (const SearchServer* server : {&uncompressed_near_tie_server, &compressed_near_tie_server}) {
+        const auto cat_docs = server->FindTopDocuments("cat"s);
+        ASSERT_EQUAL(cat_docs.size(), 2u);
+        ASSERT_EQUAL(cat_docs[0].id, 11);
+        ASSERT_EQUAL(cat_docs[1].id, 10);
+        
+        const auto rat_docs = server->FindTopDocuments("rat"s);
+        ASSERT_EQUAL(rat_docs.size(), 2u);
+        ASSERT_EQUAL(rat_docs[0].id, 20);
+        ASSERT_EQUAL(rat_docs[1].id, 21);
+    }
+}
+
 void TestSplitIntoWordsEscapesSpaces() {
-    ASSERT_EQUAL((std::vector<std::string> {"hello"s, "bro"s}), string_processing::SplitIntoWords("   hello    bro    "s));
-    ASSERT_EQUAL(std::vector<std::string>{}, string_processing::SplitIntoWords("                 "s));
+    ASSERT_EQUAL((std::vector<std::string_view> {"hello"sv, "bro"sv}), string_processing::SplitIntoWords("   hello    bro    "sv));
+    ASSERT_EQUAL(std::vector<std::string_view>{}, string_processing::SplitIntoWords("                 "sv));
+    ASSERT_EQUAL((std::vector<std::string_view> {"tab"sv, "new"sv, "line"sv}), string_processing::SplitIntoWords("\ttab\nnew \r\n line\v"sv));
+}
+
+void TestSplitIntoWordsMatchesStringStream() {
+    std::string text;
+    
+    // words and gaps of every length cross the block boundaries of the vectorized search
+    for (int i = 0; i < 200; ++i) {
+        text += std::string(static_cast<size_t>(i % 37 + 1), static_cast<char>('a' + i % 26));
+        text += std::string(static_cast<size_t>(i % 5 + 1), " \t\n\v\f\r"[i % 6]);
+    }
+    
+    std::istringstream text_stream(text);
+    
+    std::vector<std::string> expected_words;
+    
+    std::string word;
+    while (text_stream >> word) {
+        expected_words.push_back(word);
+    }
+    
+    const std::vector<std::string_view> words = string_processing::SplitIntoWords(text);
+    
+    ASSERT_EQUAL(words.size(), expected_words.size());
+    
+    for (size_t i = 0; i < words.size(); ++i) {
+        ASSERT_EQUAL(words[i], expected_words[i]);
+    }
+}
+
+void TestSearchServerCopyOwnsItsWords() {
+    SearchServer copy;
+    
+    {
+        SearchServer search_server("in"s);
+        
+        search_server.AddDocument(1, "cat in the city"s, DocumentStatus::kActual, {1});
+        search_server.AddDocument(2, "dog in the park"s, DocumentStatus::kActual, {1});
+        
+        copy = search_server;
+    }
+    
+    const auto [words, status] = copy.MatchDocument("city cat dog"s, 1);
+    
+    ASSERT_EQUAL(words, (std::vector<std::string_view>{"cat"sv, "city"sv}));
+    ASSERT_EQUAL(copy.GetWordFrequencies(2).count("park"sv), 1u);
+    
+    copy.RemoveDocument(2);
+    
+    ASSERT(copy.FindTopDocuments("park"s).empty());
 }
 
 void TestAddDocumentWithRepeatingId() {
@@ -456,16 +1859,34 @@ void TestSearchNonExistentWord() {
 
 void TestSearchServer() {
     RUN_TEST(TestStopWordsExclusion);
+    RUN_TEST(TestAddDocumentsBatch);
     RUN_TEST(TestAddedDocumentsCanBeFound);
     RUN_TEST(TestMinusWordsExcludeDocuments);
     RUN_TEST(TestMatchDocumentResults);
+    RUN_TEST(TestParallelMatchDocument);
+    RUN_TEST(TestProcessQueries);
     RUN_TEST(TestFindTopDocumentsResultsSorting);
+    RUN_TEST(TestMaxResultDocumentCount);
     RUN_TEST(TestRatingsCalculation);
     RUN_TEST(TestFilteringByPredicate);
     RUN_TEST(TestFilteringByStatus);
     RUN_TEST(TestRelevanceCalculation);
     RUN_TEST(TestSearchNonExistentWord);
+    RUN_TEST(TestCachedInverseDocumentFrequencyFollowsIndexChanges);
+    RUN_TEST(TestParallelFindTopDocuments);
+    RUN_TEST(TestResultCache);
+    RUN_TEST(TestRequestQueueTimeWindow);
+    RUN_TEST(TestQueryAnalytics);
+    RUN_TEST(TestConcurrentRequestQueue);
+    RUN_TEST(TestPrunedTopDocumentsMatchExhaustiveSearch);
+    RUN_TEST(TestShardedSearchServer);
+    RUN_TEST(TestVersionedSearchServer);
+    RUN_TEST(TestConcurrentSearchServer);
+    RUN_TEST(TestPostingList);
+    RUN_TEST(TestCompressedPostingList);
     RUN_TEST(TestSplitIntoWordsEscapesSpaces);
+    RUN_TEST(TestSplitIntoWordsMatchesStringStream);
+    RUN_TEST(TestSearchServerCopyOwnsItsWords);
     RUN_TEST(TestAddDocumentWithRepeatingId);
     RUN_TEST(TestAddDocumentWithNegativeId);
     RUN_TEST(TestAddDocumentWithSpecialSymbol);
@@ -475,6 +1896,12 @@ void TestSearchServer() {
     RUN_TEST(TestIteratingOverSearchServer);
     RUN_TEST(TestGetWordFrequencies);
     RUN_TEST(TestDeletingDocument);
+    RUN_TEST(TestDeletingDocumentKeepsOthersIntact);
+    RUN_TEST(TestDeletingDocumentsInBatchAndInParallel);
     RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestRemoveDuplicatesReturnsIds);
+    RUN_TEST(TestIndexSnapshot);
+    RUN_TEST(TestWriteAheadLogRecovery);
+    RUN_TEST(TestNearDuplicates);
 }
 
@@ -0,0 +1,134 @@
+#include "versioned_search_server.hpp"
+
+VersionedSearchServer::VersionedSearchServer(SearchServer search_server)
+: version_(MakeVersion(std::move(search_server))) {
+}
+
+VersionedSearchServer::Version VersionedSearchServer::GetVersion() const {
+    return std::atomic_load(&version_);
+}
+
+bool VersionedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                        const std::vector<int>& ratings) {
+    bool is_added = false;
+    
+    ApplyWrite([&](SearchServer& search_server) {
+        is_added = search_server.AddDocument(document_id, document, status, ratings);
+    });
+    
+    return is_added;
+} // AddDocument
+
+void VersionedSearchServer::AddDocuments(const std::vector<RawDocument>& documents) {
+    ApplyWrite([&documents](SearchServer& search_server) {
+        search_server.AddDocuments(documents);
+    });
+}
+
+void VersionedSearchServer::RemoveDocument(int document_id) {
+    ApplyWrite([document_id](SearchServer& search_server) {
+        search_server.RemoveDocument(document_id);
+    });
+}
+
+int VersionedSearchServer::GetDocumentCount() const {
+    return GetVersion()->GetDocumentCount();
+}
+
+std::vector<Document> VersionedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus desired_status,
+                                                              int max_result_document_count) const {
+    const Version version = GetVersion();
+    
+    return version->FindTopDocuments(raw_query, desired_status, max_result_document_count);
+} // FindTopDocuments
+
+void VersionedSearchServer::Checkpoint(const std::string& snapshot_path) {
+    std::lock_guard guard(write_mutex_);
+    
+    // published versions have flushed their log records, so the log holds everything the snapshot does
+    version_->Checkpoint(snapshot_path);
+}
+
+size_t VersionedSearchServer::GetRetiredVersionCount() const {
+    // no copy is being made while the lock is held, so every counted version but the current one is retired
+    std::lock_guard guard(write_mutex_);
+    
+    return version_count_->load() - 1;
+}
+
+std::shared_ptr<SearchServer> VersionedSearchServer::MakeVersion(SearchServer search_server) const {
+    ++*version_count_;
+    
+    return std::shared_ptr<SearchServer>(new SearchServer(std::move(search_server)),
+                                         [version_count = version_count_](const SearchServer* version) {
+        delete version;
+        --*version_count;
+    });
+} // MakeVersion
+
+std::shared_ptr<SearchServer> VersionedSearchServer::CopyVersion() const {
+    // writers are serialized, so the current version is not replaced meanwhile
+    const SearchServer& version = *version_;
+    auto next_version = MakeVersion(version);
+    
+    // a copy is not attached to the log of the original
+    if (auto write_ahead_log = version.GetWriteAheadLog()) {
+        next_version->AttachWriteAheadLog(std::move(write_ahead_log));
+        next_version->DeferWriteAheadLog();
+    }
+    
+    return next_version;
+} // CopyVersion
+
+void VersionedSearchServer::ApplyWrite(std::function<void(SearchServer&)> apply) {
+    PendingWrite write{std::move(apply), nullptr};
+    
+    {
+        std::lock_guard guard(pending_writes_mutex_);
+        pending_writes_.push_back(&write);
+    }
+    
+    std::lock_guard write_guard(write_mutex_);
+    
+    std::vector<PendingWrite*> writes;
+    
+    {
+        std::lock_guard guard(pending_writes_mutex_);
+        writes.swap(pending_writes_);
+    }
+    
+    // the change may have been applied already by the writer holding the lock before,
+    // which is finished by now, the changes left are applied here
+    if (!writes.empty()) {
+        const std::shared_ptr<SearchServer> next_version = CopyVersion();
+        
+        // a failed change leaves the index untouched and fails alone
+        for (PendingWrite* pending_write : writes) {
+            try {
+                pending_write->apply(*next_version);
+            } catch (...) {
+                pending_write->error = std::current_exception();
+            }
+        }
+        
+        try {
+            next_version->FlushDeferredLog();
+            Publish(next_version);
+        } catch (...) {
+            for (PendingWrite* pending_write : writes) {
+                if (!pending_write->error) {
+                    pending_write->error = std::current_exception();
+                }
+            }
+        }
+    }
+    
+    if (write.error) {
+        std::rethrow_exception(write.error);
+    }
+} // ApplyWrite
+
+void VersionedSearchServer::Publish(Version version) {
+    // the replaced version is freed here unless a query still holds it
+    std::atomic_exchange(&version_, std::move(version));
+} // Publish
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.hpp"
+#include "search_server.hpp"
+
+// SearchServer shared by query threads and writers. Every change is made to a copy of the
+// current index, which is then published atomically; a query pins the version it started
+// with and never waits for writers. The copy shares words, postings and words of documents
+// with the current version, only the changed posting lists are copied.
+// A write-ahead log attached to the server passes from every version to the next one.
+// Still, the dictionary and the document table are copied entry by entry, so every published
+// version costs O(words + documents) time and memory however small the change is. Single changes
+// made by concurrent writers are therefore combined: whoever gets the write lock applies every
+// waiting change to one copy and publishes them together. Many changes of one thread are best
+// made in one Update, and a stream of small writes to a large index is better batched by the caller.
+// A replaced version is freed by whoever drops it last: the writer replacing it if no query holds it,
+// the last query holding it otherwise
+class VersionedSearchServer {
+public:
+    using Version = std::shared_ptr<const SearchServer>;
+    
+public:
+    explicit VersionedSearchServer(SearchServer search_server);
+    
+public:
+    // The version stays valid and unchanged for as long as it is held
+    Version GetVersion() const;
+    
+    // Applies every change made by modification(SearchServer&) in a single new version.
+    // The changes are logged only after modification returns, so if it throws nothing
+    // is published and nothing is logged
+    template<typename Modification>
+    void Update(Modification modification);
+    
+    bool AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    
+    void AddDocuments(const std::vector<RawDocument>& documents);
+    
+    void RemoveDocument(int document_id);
+    
+    int GetDocumentCount() const;
+    
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           DocumentStatus desired_status = DocumentStatus::kActual,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    template<typename Predicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = SearchServer::kMaxResultDocumentCount) const;
+    
+    // Saves a snapshot of the current version and lets the log drop the changes it contains.
+    // Writers wait meanwhile, queries do not
+    void Checkpoint(const std::string& snapshot_path);
+    
+    // Versions replaced by writers and still held by queries
+    size_t GetRetiredVersionCount() const;
+    
+private:
+    // A change that either fails before touching the index or is applied completely,
+    // so it can share a version with other changes
+    struct PendingWrite {
+        std::function<void(SearchServer&)> apply;
+        std::exception_ptr error;
+    };
+    
+private:
+    // The version is counted in version_count_ until it is deleted
+    std::shared_ptr<SearchServer> MakeVersion(SearchServer search_server) const;
+    
+    // Called with write_mutex_ held. The copy logs its changes only on FlushDeferredLog
+    std::shared_ptr<SearchServer> CopyVersion() const;
+    
+    void ApplyWrite(std::function<void(SearchServer&)> apply);
+    
+    void Publish(Version version);
+    
+private:
+    // shared with the deleters of versions, which may outlive the server
+    std::shared_ptr<std::atomic<size_t>> version_count_ = std::make_shared<std::atomic<size_t>>(0);
+    
+    // writers are serialized, queries only load the pointer
+    mutable std::mutex write_mutex_;
+    Version version_;
+    
+    // changes waiting for the write lock, they point to the stacks of their writers
+    std::mutex pending_writes_mutex_;
+    std::vector<PendingWrite*> pending_writes_;
+};
+
+template<typename Modification>
+void VersionedSearchServer::Update(Modification modification) {
+    std::lock_guard guard(write_mutex_);
+    
+    const std::shared_ptr<SearchServer> next_version = CopyVersion();
+    
+    modification(*next_version);
+    
+    next_version->FlushDeferredLog();
+    
+    Publish(next_version);
+} // Update
+
+template<typename Predicate>
+std::vector<Document> VersionedSearchServer::FindTopDocuments(std::string_view raw_query, Predicate predicate,
+                                                              int max_result_document_count) const {
+    const Version version = GetVersion();
+    
+    return version->FindTopDocuments(raw_query, predicate, max_result_document_count);
+} // FindTopDocuments with predicate
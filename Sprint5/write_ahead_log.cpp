@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "write_ahead_log.hpp"
+#include "file_sync.hpp"
+
+using namespace std::literals;
+
+// Record layout, all numbers in the byte order of the machine that wrote it:
+//   uint32 payload size, uint32 CRC32 of the payload
+//   payload: uint64 sequence number, uint8 operation, int32 document id, int32 status,
+//            uint32 rating count, int32 ratings, uint32 content length, content bytes
+// A checkpoint record keeps the numbering when compaction drops every other record.
+namespace {
+
+constexpr LogOperation kCheckpoint = static_cast<LogOperation>(0xFF);
+constexpr uint32_t kMaxPayloadSize = 1u << 30;
+
+uint32_t ComputeCrc32(std::string_view data) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> result {};
+        
+        for (uint32_t i = 0; i < result.size(); ++i) {
+            uint32_t value = i;
+            
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            
+            result[i] = value;
+        }
+        
+        return result;
+    }();
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    
+    for (const char c : data) {
+        crc = table[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename Value>
+void AppendValue(std::string& buffer, const Value& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string EncodeRecord(const LogRecord& record) {
+    std::string payload;
+    
+    AppendValue(payload, record.sequence_number);
+    AppendValue(payload, static_cast<uint8_t>(record.operation));
+    AppendValue(payload, static_cast<int32_t>(record.document_id));
+    AppendValue(payload, static_cast<int32_t>(record.status));
+    AppendValue(payload, static_cast<uint32_t>(record.ratings.size()));
+    
+    for (const int rating : record.ratings) {
+        AppendValue(payload, static_cast<int32_t>(rating));
+    }
+    
+    AppendValue(payload, static_cast<uint32_t>(record.content.size()));
+    payload.append(record.content);
+    
+    std::string bytes;
+    
+    AppendValue(bytes, static_cast<uint32_t>(payload.size()));
+    AppendValue(bytes, ComputeCrc32(payload));
+    bytes.append(payload);
+    
+    return bytes;
+}
+
+// Bounds-checked reading of a payload
+class PayloadReader {
+public:
+    explicit PayloadReader(std::string_view payload): payload_(payload) {}
+    
+public:
+    template <typename Value>
+    bool Read(Value& value) {
+        if (payload_.size() < sizeof(value)) {
+            return false;
+        }
+        
+        std::memcpy(&value, payload_.data(), sizeof(value));
+        payload_.remove_prefix(sizeof(value));
+        
+        return true;
+    }
+    
+    bool Read(std::string& text, size_t length) {
+        if (payload_.size() < length) {
+            return false;
+        }
+        
+        text.assign(payload_.substr(0, length));
+        payload_.remove_prefix(length);
+        
+        return true;
+    }
+    
+    bool IsFinished() const {
+        return payload_.empty();
+    }
+    
+private:
+    std::string_view payload_;
+};
+
+bool DecodePayload(std::string_view payload, LogRecord& record) {
+    PayloadReader reader(payload);
+    
+    uint8_t operation = 0;
+    int32_t document_id = 0;
+    int32_t status = 0;
+    uint32_t rating_count = 0;
+    
+    if (!reader.Read(record.sequence_number) || !reader.Read(operation) || !reader.Read(document_id)
+        || !reader.Read(status) || !reader.Read(rating_count) || rating_count > payload.size() / sizeof(int32_t)) {
+        return false;
+    }
+    
+    record.operation = static_cast<LogOperation>(operation);
+    record.document_id = document_id;
+    record.status = static_cast<DocumentStatus>(status);
+    record.ratings.resize(rating_count);
+    
+    for (int& rating : record.ratings) {
+        int32_t value = 0;
+        
+        if (!reader.Read(value)) {
+            return false;
+        }
+        
+        rating = value;
+    }
+    
+    uint32_t content_length = 0;
+    
+    return reader.Read(content_length) && reader.Read(record.content, content_length) && reader.IsFinished();
+}
+
+// Returns false at the end of the log and at the first torn or corrupted record,
+// bytes receive the record exactly as it is stored
+bool ReadRecord(std::istream& input, LogRecord& record, std::string& bytes) {
+    uint32_t record_header[2] = {};
+    
+    if (!input.read(reinterpret_cast<char*>(record_header), sizeof(record_header))) {
+        return false;
+    }
+    
+    const auto [payload_size, crc] = record_header;
+    
+    if (payload_size > kMaxPayloadSize) {
+        return false;
+    }
+    
+    bytes.assign(reinterpret_cast<const char*>(record_header), sizeof(record_header));
+    bytes.resize(sizeof(record_header) + payload_size);
+    
+    if (!input.read(bytes.data() + sizeof(record_header), payload_size)) {
+        return false;
+    }
+    
+    const std::string_view payload = std::string_view(bytes).substr(sizeof(record_header));
+    
+    return ComputeCrc32(payload) == crc && DecodePayload(payload, record);
+}
+
+void WriteAll(int file_descriptor, std::string_view bytes) {
+    while (!bytes.empty()) {
+        const ssize_t written = write(file_descriptor, bytes.data(), bytes.size());
+        
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            throw std::runtime_error("cannot write to write-ahead log: "s + std::strerror(errno));
+        }
+        
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& path): path_(path) {
+    file_descriptor_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    
+    if (file_descriptor_ < 0) {
+        throw std::runtime_error("cannot open write-ahead log "s + path_);
+    }
+    
+    std::ifstream input(path_, std::ios::binary);
+    LogRecord record;
+    std::string bytes;
+    
+    while (ReadRecord(input, record, bytes)) {
+        file_size_ += bytes.size();
+        last_sequence_number_ = record.sequence_number;
+    }
+    
+    // a crash in the middle of a write leaves a torn record, which is never committed
+    struct stat file_status {};
+    
+    if (fstat(file_descriptor_, &file_status) != 0
+        || (static_cast<uint64_t>(file_status.st_size) > file_size_ && ftruncate(file_descriptor_, file_size_) != 0)) {
+        close(file_descriptor_);
+        throw std::runtime_error("cannot recover write-ahead log "s + path_);
+    }
+    
+    durable_sequence_number_ = last_sequence_number_;
+} // WriteAheadLog
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard guard(compaction_mutex_);
+        
+        // an error of the last compaction cannot be thrown from here, the log is complete anyway
+        if (compaction_thread_.joinable()) {
+            compaction_thread_.join();
+        }
+    }
+    
+    close(file_descriptor_);
+}
+
+uint64_t WriteAheadLog::AppendAddDocument(int document_id, std::string_view content, DocumentStatus status,
+                                          const std::vector<int>& ratings) {
+    return Append({0, LogOperation::kAddDocument, document_id, status, ratings, std::string(content)});
+}
+
+uint64_t WriteAheadLog::AppendRemoveDocument(int document_id) {
+    return Append({0, LogOperation::kRemoveDocument, document_id, DocumentStatus::kActual, {}, {}});
+}
+
+uint64_t WriteAheadLog::Append(LogRecord record) {
+    std::lock_guard guard(mutex_);
+    
+    record.sequence_number = last_sequence_number_ + 1;
+    
+    WriteToFile(EncodeRecord(record));
+    
+    return last_sequence_number_ = record.sequence_number;
+} // Append
+
+void WriteAheadLog::WriteToFile(const std::string& bytes) {
+    try {
+        WriteAll(file_descriptor_, bytes);
+    } catch (...) {
+        // a partly written record would hide every record after it
+        [[maybe_unused]] const int result = ftruncate(file_descriptor_, file_size_);
+        throw;
+    }
+    
+    file_size_ += bytes.size();
+} // WriteToFile
+
+void WriteAheadLog::Commit(uint64_t sequence_number) {
+    std::unique_lock lock(mutex_);
+    
+    sequence_number = std::min(sequence_number, last_sequence_number_);
+    
+    // the first waiting thread syncs on behalf of everyone who appended before it,
+    // the others wait for its result instead of issuing their own fsync
+    while (durable_sequence_number_ < sequence_number) {
+        if (is_syncing_) {
+            sync_finished_.wait(lock);
+            continue;
+        }
+        
+        is_syncing_ = true;
+        
+        const uint64_t synced_sequence_number = last_sequence_number_;
+        const int file_descriptor = file_descriptor_;
+        
+        lock.unlock();
+        const bool is_synced = fsync(file_descriptor) == 0;
+        lock.lock();
+        
+        is_syncing_ = false;
+        sync_finished_.notify_all();
+        
+        if (!is_synced) {
+            throw std::runtime_error("cannot sync write-ahead log "s + path_);
+        }
+        
+        durable_sequence_number_ = std::max(durable_sequence_number_, synced_sequence_number);
+    }
+} // Commit
+
+uint64_t WriteAheadLog::GetLastSequenceNumber() const {
+    std::lock_guard guard(mutex_);
+    
+    return last_sequence_number_;
+}
+
+void WriteAheadLog::Replay(uint64_t after_sequence_number, const std::function<void(const LogRecord&)>& apply) const {
+    std::ifstream input(path_, std::ios::binary);
+    LogRecord record;
+    std::string bytes;
+    
+    while (ReadRecord(input, record, bytes)) {
+        if (record.operation != kCheckpoint && record.sequence_number > after_sequence_number) {
+            apply(record);
+        }
+    }
+} // Replay
+
+void WriteAheadLog::CompactAsync(uint64_t sequence_number) {
+    std::lock_guard guard(compaction_mutex_);
+    
+    JoinCompaction();
+    
+    compaction_thread_ = std::thread([this, sequence_number] {
+        // the log stays complete if compaction fails, so the error waits for the next caller
+        try {
+            Compact(sequence_number);
+        } catch (...) {
+            compaction_error_ = std::current_exception();
+        }
+    });
+} // CompactAsync
+
+void WriteAheadLog::WaitForCompaction() {
+    std::lock_guard guard(compaction_mutex_);
+    
+    JoinCompaction();
+}
+
+void WriteAheadLog::JoinCompaction() {
+    if (compaction_thread_.joinable()) {
+        compaction_thread_.join();
+    }
+    
+    if (compaction_error_) {
+        std::rethrow_exception(std::exchange(compaction_error_, nullptr));
+    }
+}
+
+void WriteAheadLog::Compact(uint64_t sequence_number) {
+    uint64_t copied_size = 0;
+    
+    {
+        std::lock_guard guard(mutex_);
+        
+        copied_size = file_size_;
+        sequence_number = std::min(sequence_number, last_sequence_number_);
+    }
+    
+    const std::string compacted_path = path_ + ".compact"s;
+    const int compacted_file_descriptor = open(compacted_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    
+    if (compacted_file_descriptor < 0) {
+        throw std::runtime_error("cannot create "s + compacted_path);
+    }
+    
+    try {
+        WriteAll(compacted_file_descriptor, EncodeRecord({sequence_number, kCheckpoint, 0, DocumentStatus::kActual, {}, {}}));
+        
+        // the bulk of the log is copied without blocking appends
+        std::ifstream input(path_, std::ios::binary);
+        LogRecord record;
+        std::string bytes;
+        
+        for (uint64_t position = 0; position < copied_size && ReadRecord(input, record, bytes); position += bytes.size()) {
+            if (record.sequence_number > sequence_number) {
+                WriteAll(compacted_file_descriptor, bytes);
+            }
+        }
+        
+        std::unique_lock lock(mutex_);
+        
+        // the descriptor must not be replaced under a running fsync
+        sync_finished_.wait(lock, [this] {
+            return !is_syncing_;
+        });
+        
+        // records appended meanwhile are all newer than sequence_number
+        std::string appended_bytes(file_size_ - copied_size, '\0');
+        input.clear();
+        input.seekg(static_cast<std::streamoff>(copied_size));
+        
+        if (!input.read(appended_bytes.data(), static_cast<std::streamsize>(appended_bytes.size()))) {
+            throw std::runtime_error("cannot read write-ahead log "s + path_);
+        }
+        
+        WriteAll(compacted_file_descriptor, appended_bytes);
+        
+        if (fsync(compacted_file_descriptor) != 0 || std::rename(compacted_path.c_str(), path_.c_str()) != 0) {
+            throw std::runtime_error("cannot replace write-ahead log "s + path_);
+        }
+        
+        close(file_descriptor_);
+        
+        file_descriptor_ = compacted_file_descriptor;
+        file_size_ = static_cast<uint64_t>(lseek(file_descriptor_, 0, SEEK_END));
+        
+        // the rename itself is durable only once the directory is synced, commits wait for it under the lock
+        file_sync::SyncParentDirectory(path_);
+        
+        // the compacted file is synced, so everything in it is durable
+        durable_sequence_number_ = last_sequence_number_;
+        
+        sync_finished_.notify_all();
+    } catch (...) {
+        // once renamed, the compacted file is the log
+        if (file_descriptor_ != compacted_file_descriptor) {
+            close(compacted_file_descriptor);
+            std::remove(compacted_path.c_str());
+        }
+        
+        throw;
+    }
+} // Compact
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "document.hpp"
+
+enum class LogOperation : uint8_t {
+    kAddDocument = 1,
+    kRemoveDocument = 2,
+};
+
+struct LogRecord {
+    uint64_t sequence_number = 0;
+    LogOperation operation = LogOperation::kAddDocument;
+    int document_id = 0;
+    DocumentStatus status = DocumentStatus::kActual;
+    std::vector<int> ratings;
+    std::string content;
+};
+
+// Append-only log of index changes. Every record carries a growing sequence number and
+// a CRC32 of its contents; a torn or corrupted tail is cut off when the log is opened.
+// Commit makes records durable, concurrent commits share a single fsync.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(const std::string& path);
+    
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    
+    ~WriteAheadLog();
+    
+public:
+    // Returns the sequence number of the record, which is durable only after Commit
+    uint64_t AppendAddDocument(int document_id, std::string_view content, DocumentStatus status,
+                               const std::vector<int>& ratings);
+    
+    uint64_t AppendRemoveDocument(int document_id);
+    
+    // Blocks until every record up to sequence_number is on disk
+    void Commit(uint64_t sequence_number);
+    
+    uint64_t GetLastSequenceNumber() const;
+    
+    // Calls apply for every record with a sequence number greater than after_sequence_number
+    void Replay(uint64_t after_sequence_number, const std::function<void(const LogRecord&)>& apply) const;
+    
+    // Drops records up to sequence_number on a background thread, appends and commits go on meanwhile.
+    // If the previous compaction failed, its error is thrown instead and nothing is started
+    void CompactAsync(uint64_t sequence_number);
+    
+    // Blocks until a running compaction is finished and throws its error, if any
+    void WaitForCompaction();
+    
+private:
+    uint64_t Append(LogRecord record);
+    
+    void Compact(uint64_t sequence_number);
+    
+    // Called with compaction_mutex_ held
+    void JoinCompaction();
+    
+    void WriteToFile(const std::string& bytes);
+    
+private:
+    const std::string path_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable sync_finished_;
+    
+    int file_descriptor_ = -1;
+    uint64_t file_size_ = 0;
+    
+    uint64_t last_sequence_number_ = 0;
+    uint64_t durable_sequence_number_ = 0;
+    bool is_syncing_ = false;
+    
+    std::mutex compaction_mutex_;
+    std::thread compaction_thread_;
+    // set by the compaction thread, read only after it is joined
+    std::exception_ptr compaction_error_;
+};